@@ -0,0 +1,87 @@
+// Formant rendering cost per output sample for vowel heavy phrases, where
+// most frames are voiced and go through the formant tables, against
+// consonant heavy ones. Reports the best of 15 repetitions. Pass the
+// number of rounds per repetition as the first argument.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sam.h"
+#include "reciter.h"
+
+int debug = 0;
+
+static const char *kVowelTexts[] = {
+    "OH MY, I LOVE YOU ALL.",
+    "A LOW WAILING MOAN ROLLED ALONG THE VALLEY.",
+    "WE ARE ALL ALONE ON A LONELY ROAD.",
+    "OLIVE OIL, OCEAN AIR, AND A YELLOW MOON.",
+    "I OWE YOU A LOAN, ELLIE.",
+};
+
+static const char *kConsonantTexts[] = {
+    "SHE SELLS SEA SHELLS BY THE SEA SHORE.",
+    "SIX THICK THISTLE STICKS.",
+    "FRESH FISH, CHIPS, AND SPICED PECAN SCONES.",
+    "STRICT SCRIPTS SKIP SPLIT SPECS.",
+    "ZEBRA VISION, JUDGE CHURCH, THIRTY FIFTH STREET.",
+};
+
+#define TEXT_COUNT 5
+#define REPETITIONS 15
+
+// Returns the best time per sample in nanoseconds, or a negative value if
+// a text does not convert.
+static double Run(SamContext *ctx, const char **texts, int rounds)
+{
+    unsigned char phonemes[TEXT_COUNT][256];
+    double best = -1;
+    int r, i, t;
+
+    for (t = 0; t < TEXT_COUNT; t++) {
+        memset(phonemes[t], 0, sizeof(phonemes[t]));
+        strcpy((char*)phonemes[t], texts[t]);
+        strcat((char*)phonemes[t], "[");
+        if (!SamTextToPhonemes(ctx, phonemes[t])) return -1;
+    }
+
+    for (r = 0; r < REPETITIONS; r++) {
+        long samples = 0;
+        clock_t start = clock();
+        double ns;
+
+        for (i = 0; i < rounds; i++) {
+            for (t = 0; t < TEXT_COUNT; t++) {
+                SamSetInput(ctx, phonemes[t]);
+                SamMain(ctx);
+                samples += SamGetBufferLength(ctx) / 50;
+            }
+        }
+        ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / samples;
+        if (best < 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 50;
+    SamContext *ctx = SamCreateContext();
+    double vowel, consonant;
+
+    if (ctx == NULL || rounds <= 0) return 1;
+
+    vowel = Run(ctx, kVowelTexts, rounds);
+    consonant = Run(ctx, kConsonantTexts, rounds);
+    if (vowel < 0 || consonant < 0) {
+        printf("a text did not convert\n");
+        return 1;
+    }
+
+    printf("vowel heavy %.2f ns/sample, consonant heavy %.2f ns/sample\n", vowel, consonant);
+
+    SamDestroyContext(ctx);
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Time taken to set up the frames of one segment: RenderBegin (frames,
+// transitions, pitch contour and amplitude rescale) and CreateTransitions
+// on its own. The long segment is timed first. The short one then still
+// rescales the frames the long one wrote, as the original engine did.
+
+#include <stdio.h>
+#include <time.h>
+
+#include "sam.h"
+#include "samcontext.h"
+#include "render.h"
+
+int debug = 0;
+
+static const int kCalls = 5000;
+static const int kRepeats = 20;
+
+static const char *kSegments[] = {
+    " /HEHLOW4 MAY NEYM IHZ SAE4M AY4 AEM AH KAHMPYUWTER PROWGRAEM",
+    " AY4 AEM SAE4M",
+};
+
+// Best of kRepeats runs, in nanoseconds per call.
+static double TimeRenderBegin(SamContext *ctx)
+{
+    double best = 0;
+    int r, i;
+    for (r = 0; r < kRepeats; r++) {
+        clock_t start = clock();
+        double ns;
+        for (i = 0; i < kCalls; i++) RenderBegin(ctx);
+        ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / kCalls;
+        if (r == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+static double TimeCreateTransitions(SamContext *ctx)
+{
+    double best = 0;
+    int r, i;
+    for (r = 0; r < kRepeats; r++) {
+        clock_t start = clock();
+        double ns;
+        for (i = 0; i < kCalls; i++) CreateTransitions(ctx);
+        ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / kCalls;
+        if (r == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+int main()
+{
+    SamContext *ctx = SamCreateContext();
+    int k;
+
+    if (ctx == NULL) return 1;
+
+    for (k = 0; k < (int)(sizeof(kSegments) / sizeof(kSegments[0])); k++) {
+        unsigned char sample;
+        double renderBegin, createTransitions;
+
+        // leaves the segment in the output tables
+        SamSetInput(ctx, (unsigned char*)kSegments[k]);
+        if (!SamStreamBegin(ctx) || SamStreamRead(ctx, &sample, 1) != 1) {
+            printf("segment %d did not render\n", k);
+            return 1;
+        }
+
+        renderBegin = TimeRenderBegin(ctx);
+        createTransitions = TimeCreateTransitions(ctx);
+        printf("segment %d (%3d frames): RenderBegin %6.0f ns, CreateTransitions %6.0f ns\n",
+               k, ctx->framesUsed, renderBegin, createTransitions);
+    }
+
+    SamDestroyContext(ctx);
+    return 0;
+}
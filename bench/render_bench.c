@@ -0,0 +1,64 @@
+// Whole renders: SamMain over six phrases of reciter output, repeated.
+// Reports the time per render and how much faster than real time the
+// engine runs. Pass the number of rounds as the first argument.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sam.h"
+#include "reciter.h"
+
+int debug = 0;
+
+static const char *kTexts[] = {
+    "HELLO WORLD, THIS IS SAM SPEAKING.",
+    "SHE SELLS SEA SHELLS BY THE SEA SHORE. SIX THICK THISTLE STICKS.",
+    "I AM SAM",
+    "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG WHILE THE HUNGRY WIZARD QUIETLY VEXES THE JUMBLED SPHINX.",
+    "ZEBRA VISION JUDGE CHURCH? YES!",
+    "A LOVELY MORNING IN OCTOBER, AWAY WE GO ALONG THE ROAD.",
+};
+
+#define TEXT_COUNT ((int)(sizeof(kTexts) / sizeof(kTexts[0])))
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+    unsigned char phonemes[TEXT_COUNT][256];
+    SamContext *ctx = SamCreateContext();
+    long samples = 0;
+    clock_t start;
+    double seconds;
+    int i, t;
+
+    if (ctx == NULL || rounds <= 0) return 1;
+
+    for (t = 0; t < TEXT_COUNT; t++) {
+        memset(phonemes[t], 0, sizeof(phonemes[t]));
+        strcpy((char*)phonemes[t], kTexts[t]);
+        strcat((char*)phonemes[t], "[");
+        if (!SamTextToPhonemes(ctx, phonemes[t])) {
+            printf("text %d did not convert\n", t);
+            return 1;
+        }
+    }
+
+    start = clock();
+    for (i = 0; i < rounds; i++) {
+        for (t = 0; t < TEXT_COUNT; t++) {
+            SamSetInput(ctx, phonemes[t]);
+            SamMain(ctx);
+            samples += SamGetBufferLength(ctx) / 50;
+        }
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("renders %d, samples %ld, %.3f s: %.1f us/render, %.0fx real time\n",
+           rounds * TEXT_COUNT, samples, seconds, seconds * 1e6 / (rounds * TEXT_COUNT),
+           samples / 22050.0 / seconds);
+
+    SamDestroyContext(ctx);
+    return 0;
+}
@@ -1,11 +1,16 @@
 #include "SAMBridge.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cstdio>
 #include <cstring>
-#include <mutex>
+#include <list>
+#include <memory>
+#include <unordered_map>
 
 extern "C" {
+#include "lexicon.h"
 #include "reciter.h"
 #include "sam.h"
 }
@@ -17,13 +22,308 @@ int debug = 0;
 namespace sam_bridge {
 
 namespace {
-constexpr size_t kSAMInputBytes = 256;
-constexpr unsigned char kReciterEndMarker = '[';
+constexpr size_t kWordCacheCapacity = 2048;
+constexpr size_t kReciterWordBytes = 256;
+
+std::atomic<uint64_t> sWordCacheHits{0};
+std::atomic<uint64_t> sWordCacheMisses{0};
 
 int ClampSAMParam(int value)
 {
   return std::clamp(value, 0, 255);
 }
+
+// Lets the engine write straight into the caller's PCM vector. Called from
+// C, so nothing may be thrown; NULL makes the render fail instead.
+char* GrowPCMVector(void* user, char* /*buffer*/, int size)
+{
+  auto* pcm = static_cast<std::vector<uint8_t>*>(user);
+  try
+  {
+    pcm->resize(static_cast<size_t>(size));
+  }
+  catch (...)
+  {
+    return nullptr;
+  }
+  return reinterpret_cast<char*>(pcm->data());
+}
+
+struct SAMLexiconDeleter
+{
+  void operator()(SamLexicon* lexicon) const { SamDestroyLexicon(lexicon); }
+};
+
+// A dictionary and the hash of the file it was parsed from.
+struct LoadedLexicon
+{
+  std::unique_ptr<SamLexicon, SAMLexiconDeleter> lexicon;
+  uint64_t hash = 0;
+};
+
+// Shared by all threads; replaced as a whole by LoadLexicon.
+std::shared_ptr<const LoadedLexicon> sLexicon;
+
+std::shared_ptr<const SamLexicon> GetLexicon()
+{
+  std::shared_ptr<const LoadedLexicon> loaded = std::atomic_load(&sLexicon);
+  if (!loaded)
+    return nullptr;
+  return std::shared_ptr<const SamLexicon>(loaded, loaded->lexicon.get());
+}
+
+// 64-bit FNV-1a.
+uint64_t HashBytes(const char* data, size_t size)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+struct SAMContextDeleter
+{
+  void operator()(SamContext* ctx) const { SamDestroyContext(ctx); }
+};
+
+struct SAMPhraseDeleter
+{
+  void operator()(SamPhrase* phrase) const { SamDestroyPhrase(phrase); }
+};
+
+// Each rendering thread owns its own engine context, so renders from
+// different plugin instances no longer serialise on a shared lock.
+SamContext* GetThreadContext()
+{
+  thread_local std::unique_ptr<SamContext, SAMContextDeleter> sContext(SamCreateContext());
+  return sContext.get();
+}
+
+// The folding SamTextToPhonemes applies to its input.
+char FoldReciterChar(char c)
+{
+  unsigned char a = static_cast<unsigned char>(c) & 127;
+  if (a >= 112)
+    a &= 95;
+  else if (a >= 96)
+    a &= 79;
+  return static_cast<char>(a);
+}
+
+bool IsReciterVowel(char c)
+{
+  switch (FoldReciterChar(c))
+  {
+    case 'A': case 'E': case 'I': case 'O': case 'U': case 'Y':
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Least recently used reciter output per word. The key is the word plus
+// whether the next word starts with a vowel, see SamWordToPhonemes.
+class WordPhonemeCache
+{
+public:
+  // Appends the phonemes of word to out. Returns false if the reciter
+  // cannot convert the word on its own.
+  bool Append(SamContext* ctx, const std::string& word, bool beforeVowel, std::string& out)
+  {
+    std::string key = word;
+    key += beforeVowel ? '#' : ' ';
+
+    auto found = mIndex.find(key);
+    if (found != mIndex.end())
+    {
+      mEntries.splice(mEntries.begin(), mEntries, found->second);
+      out += found->second->second;
+      ++sWordCacheHits;
+      return true;
+    }
+
+    ++sWordCacheMisses;
+
+    unsigned char phonemes[kReciterWordBytes];
+    if (!SamWordToPhonemes(ctx, word.data(), static_cast<int>(word.size()), beforeVowel ? 1 : 0, phonemes))
+      return false;
+
+    mEntries.emplace_front(std::move(key), reinterpret_cast<const char*>(phonemes));
+    mIndex.emplace(mEntries.front().first, mEntries.begin());
+
+    if (mEntries.size() > kWordCacheCapacity)
+    {
+      mIndex.erase(mEntries.back().first);
+      mEntries.pop_back();
+    }
+
+    out += mEntries.front().second;
+    return true;
+  }
+
+private:
+  using Entry = std::pair<std::string, std::string>;
+
+  std::list<Entry> mEntries; // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> mIndex;
+};
+
+WordPhonemeCache& GetThreadWordCache()
+{
+  thread_local WordPhonemeCache sCache;
+  return sCache;
+}
+
+// Builds what SamTextToPhonemes would make of text from cached words: a
+// pause, then the phonemes of each word with a pause for every space.
+// Returns false if a word has to go through the full reciter.
+bool ReciteWords(SamContext* ctx, const std::string& text, const SamLexicon* lexicon,
+                 const RenderCancelToken& cancel, std::string& phonemes)
+{
+  WordPhonemeCache& cache = GetThreadWordCache();
+  size_t pos = 0;
+
+  phonemes.assign(1, ' ');
+
+  while (pos < text.size())
+  {
+    if (cancel.IsCancelled())
+      return false;
+
+    if (text[pos] == ' ')
+    {
+      phonemes += ' ';
+      ++pos;
+      continue;
+    }
+
+    const size_t end = std::min(text.find(' ', pos), text.size());
+    const bool beforeVowel = end + 1 < text.size() && IsReciterVowel(text[end + 1]);
+
+    // Lexicon words may be followed by punctuation, which still goes
+    // through the reciter.
+    if (lexicon)
+    {
+      size_t wordEnd = end;
+      while (wordEnd > pos && std::strchr(".,?!;:", text[wordEnd - 1]) != nullptr)
+        --wordEnd;
+
+      const char* entry = SamLexiconLookup(lexicon, text.data() + pos, static_cast<int>(wordEnd - pos));
+      if (entry != nullptr)
+      {
+        phonemes += entry;
+        if (wordEnd < end && !cache.Append(ctx, text.substr(wordEnd, end - wordEnd), beforeVowel, phonemes))
+          return false;
+        pos = end;
+        continue;
+      }
+    }
+
+    if (!cache.Append(ctx, text.substr(pos, end - pos), beforeVowel, phonemes))
+      return false;
+
+    pos = end;
+  }
+
+  return true;
+}
+
+// Runs the reciter over text and gives the result to ctx as its input.
+bool LoadText(SamContext* ctx, const std::string& text, const SamLexicon* lexicon, const RenderCancelToken& cancel)
+{
+  std::string upper(text.size(), '\0');
+  std::transform(text.begin(), text.end(), upper.begin(), [](char c) {
+    return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  });
+
+  // the reciter ends the text at the first '['
+  upper.resize(std::min(upper.find('['), upper.size()));
+
+  std::string phonemes;
+  if (ReciteWords(ctx, upper, lexicon, cancel, phonemes))
+    SamSetInput(ctx, reinterpret_cast<unsigned char*>(phonemes.data()));
+  else if (cancel.IsCancelled() || !SamSetText(ctx, upper.c_str()))
+    return false;
+
+  return true;
+}
+
+void SetVoice(SamContext* ctx, int speed, int pitch, int throat, int mouth)
+{
+  SamSetSpeed(ctx, static_cast<unsigned char>(ClampSAMParam(speed)));
+  SamSetPitch(ctx, static_cast<unsigned char>(ClampSAMParam(pitch)));
+  SamSetThroat(ctx, static_cast<unsigned char>(ClampSAMParam(throat)));
+  SamSetMouth(ctx, static_cast<unsigned char>(ClampSAMParam(mouth)));
+}
+
+int IsRenderCancelled(void* user)
+{
+  return static_cast<const RenderCancelToken*>(user)->IsCancelled() ? 1 : 0;
+}
+
+// Lets the engine poll a cancel token for the length of one render. Contexts
+// are reused, so the check is always removed again.
+class ScopedCancelCheck
+{
+public:
+  ScopedCancelCheck(SamContext* ctx, const RenderCancelToken& cancel)
+  : mContext(ctx)
+  {
+    if (cancel.generation != nullptr)
+      SamSetCancelCheck(ctx, IsRenderCancelled, const_cast<RenderCancelToken*>(&cancel));
+  }
+
+  ~ScopedCancelCheck() { SamSetCancelCheck(mContext, nullptr, nullptr); }
+
+  ScopedCancelCheck(const ScopedCancelCheck&) = delete;
+  ScopedCancelCheck& operator=(const ScopedCancelCheck&) = delete;
+
+private:
+  SamContext* mContext;
+};
+
+// The reciter and parser output for one text. It does not depend on the
+// voice settings, so it is rendered again as long as the text and the
+// dictionary stay the same.
+struct ParsedText
+{
+  std::string text;
+  std::shared_ptr<const SamLexicon> lexicon;
+  std::unique_ptr<SamPhrase, SAMPhraseDeleter> phrase;
+};
+
+// Returns the parse of text, reusing parsed if it was made from the same
+// text with the current dictionary.
+const SamPhrase* ParseText(SamContext* ctx, const std::string& text, ParsedText& parsed,
+                           const RenderCancelToken& cancel)
+{
+  std::shared_ptr<const SamLexicon> lexicon = GetLexicon();
+
+  if (parsed.phrase && parsed.text == text && parsed.lexicon == lexicon)
+    return parsed.phrase.get();
+
+  parsed.phrase.reset();
+  if (!LoadText(ctx, text, lexicon.get(), cancel))
+    return nullptr;
+
+  parsed.phrase.reset(SamParse(ctx));
+  if (!parsed.phrase)
+    return nullptr;
+
+  parsed.text = text;
+  parsed.lexicon = std::move(lexicon);
+  return parsed.phrase.get();
+}
+
+ParsedText& GetThreadParsedText()
+{
+  thread_local ParsedText sParsed;
+  return sParsed;
+}
+
 } // namespace
 
 bool RenderTextToPCM(const std::string& text,
@@ -31,52 +331,89 @@ bool RenderTextToPCM(const std::string& text,
                      int pitch,
                      int throat,
                      int mouth,
-                     std::vector<uint8_t>& pcmOut)
+                     std::vector<uint8_t>& pcmOut,
+                     const RenderCancelToken& cancel)
 {
-  static std::mutex sSAMMutex;
-  std::lock_guard<std::mutex> lock(sSAMMutex);
-
-  unsigned char input[kSAMInputBytes] = {};
-  size_t n = std::min(text.size(), kSAMInputBytes - 2);
-
-  for (size_t i = 0; i < n; ++i)
-    input[i] = static_cast<unsigned char>(std::toupper(static_cast<unsigned char>(text[i])));
-
-  input[n] = kReciterEndMarker;
-  input[n + 1] = 0;
-
-  if (!TextToPhonemes(input))
+  SamContext* ctx = GetThreadContext();
+  if (ctx == nullptr)
   {
     pcmOut.clear();
     return false;
   }
 
-  SetSpeed(static_cast<unsigned char>(ClampSAMParam(speed)));
-  SetPitch(static_cast<unsigned char>(ClampSAMParam(pitch)));
-  SetThroat(static_cast<unsigned char>(ClampSAMParam(throat)));
-  SetMouth(static_cast<unsigned char>(ClampSAMParam(mouth)));
-
-  SetInput(input);
+  ScopedCancelCheck cancelCheck(ctx, cancel);
 
-  if (!SAMMain())
+  const SamPhrase* phrase = ParseText(ctx, text, GetThreadParsedText(), cancel);
+  if (phrase == nullptr)
   {
     pcmOut.clear();
     return false;
   }
 
-  const int rawLength = GetBufferLength();
+  SetVoice(ctx, speed, pitch, throat, mouth);
+
+  pcmOut.clear();
+  SamSetBufferAlloc(ctx, GrowPCMVector, &pcmOut);
+  const bool rendered = SamRenderPhrase(ctx, phrase) != 0;
+  const int rawLength = SamGetBufferLength(ctx);
+  SamSetBufferAlloc(ctx, nullptr, nullptr);
+
   const int sampleCount = rawLength > 0 ? (rawLength / 50) : 0;
-  const char* rawBuffer = GetBuffer();
 
-  if (sampleCount <= 0 || rawBuffer == nullptr)
+  if (!rendered || sampleCount <= 0)
   {
     pcmOut.clear();
     return false;
   }
 
   pcmOut.resize(static_cast<size_t>(sampleCount));
-  std::memcpy(pcmOut.data(), rawBuffer, static_cast<size_t>(sampleCount));
   return true;
 }
 
+bool LoadLexicon(const std::string& path)
+{
+  // read here rather than by SamLoadLexicon, so the contents can be hashed
+  std::string text;
+  FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr)
+    return false;
+
+  char chunk[4096];
+  size_t read;
+  while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    text.append(chunk, read);
+  const bool failed = std::ferror(file) != 0;
+  std::fclose(file);
+  if (failed)
+    return false;
+
+  auto loaded = std::make_shared<LoadedLexicon>();
+  loaded->lexicon.reset(SamParseLexicon(text.data(), static_cast<int>(text.size())));
+  if (!loaded->lexicon)
+    return false;
+  loaded->hash = HashBytes(text.data(), text.size());
+
+  std::atomic_store(&sLexicon, std::shared_ptr<const LoadedLexicon>(std::move(loaded)));
+  return true;
+}
+
+void ClearLexicon()
+{
+  std::atomic_store(&sLexicon, std::shared_ptr<const LoadedLexicon>());
+}
+
+uint64_t GetLexiconHash()
+{
+  std::shared_ptr<const LoadedLexicon> loaded = std::atomic_load(&sLexicon);
+  return loaded ? loaded->hash : 0;
+}
+
+PhonemeCacheStats GetPhonemeCacheStats()
+{
+  PhonemeCacheStats stats;
+  stats.hits = sWordCacheHits.load(std::memory_order_relaxed);
+  stats.misses = sWordCacheMisses.load(std::memory_order_relaxed);
+  return stats;
+}
+
 } // namespace sam_bridge
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -8,13 +9,51 @@ namespace sam_bridge {
 
 constexpr double kSAMSourceSampleRate = 22050.0;
 
+// Generation a render was started for. Once the counter it watches has
+// moved on, the render is no longer wanted: the engine stops it at the next
+// frame or word and RenderTextToPCM returns false. A default token never
+// cancels.
+struct RenderCancelToken
+{
+  const std::atomic<uint64_t>* generation = nullptr;
+  uint64_t started = 0;
+
+  bool IsCancelled() const
+  {
+    return generation != nullptr && generation->load(std::memory_order_acquire) != started;
+  }
+};
+
 // Render text via the SAM C core and return copied unsigned 8-bit PCM at 22.05kHz.
+// The parse of the last text is kept per thread, so rendering the same text
+// with other speed, pitch, throat or mouth values only reruns synthesis.
 bool RenderTextToPCM(const std::string& text,
                      int speed,
                      int pitch,
                      int throat,
                      int mouth,
-                     std::vector<uint8_t>& pcmOut);
+                     std::vector<uint8_t>& pcmOut,
+                     const RenderCancelToken& cancel = RenderCancelToken());
 
-} // namespace sam_bridge
+// Loads a pronunciation dictionary (see src/lexicon.h) that is consulted
+// before the reciter rules by every render in the process. Returns false
+// and keeps the current dictionary if path cannot be read.
+bool LoadLexicon(const std::string& path);
+
+void ClearLexicon();
 
+// Hash of the contents of the current dictionary file, 0 without one.
+// Renders depend on the dictionary, so this is part of their cache keys.
+uint64_t GetLexiconHash();
+
+// Counters of the word phoneme caches consulted before running the
+// reciter, summed over all threads.
+struct PhonemeCacheStats
+{
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+PhonemeCacheStats GetPhonemeCacheStats();
+
+} // namespace sam_bridge
@@ -0,0 +1,374 @@
+#include "SAMDiskCache.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace sam_bridge {
+
+namespace {
+constexpr uint32_t kFileMagic = 0x53414D50; // SAMP
+constexpr uint32_t kFileVersion = 2;        // of the layout below
+constexpr uint32_t kFileAlignment = 8;
+
+// Trimming goes this far below the budget, so it is not needed again for
+// a while.
+constexpr uint64_t kTrimPercent = 75;
+
+// Native byte order: the files are local to one machine.
+struct FileHeader
+{
+  uint32_t magic;
+  uint32_t version; // kFileVersion
+  uint64_t engine;  // EngineBuildId()
+  uint64_t lexicon; // PhraseKey::lexicon
+  int32_t speed;
+  int32_t pitch;
+  int32_t throat;
+  int32_t mouth;
+  uint32_t textLength;
+  uint32_t sampleOffset; // from the start of the file
+  uint32_t sampleCount;
+  float dcBias;
+};
+
+uint32_t AlignUp(uint32_t value)
+{
+  return (value + kFileAlignment - 1) & ~(kFileAlignment - 1);
+}
+
+// 64-bit FNV-1a.
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Hash of the engine sources, set by the build. Builds that do not set it
+// fall back to the time this file was compiled, which only changes with
+// it, so they should clear the cache directory when the engine changes.
+uint64_t EngineBuildId()
+{
+#ifdef SAM_ENGINE_BUILD_ID
+  return SAM_ENGINE_BUILD_ID;
+#else
+  static const char kCompiled[] = __DATE__ " " __TIME__;
+  return HashBytes(0xcbf29ce484222325ull, kCompiled, sizeof(kCompiled) - 1);
+#endif
+}
+
+struct FileCloser
+{
+  void operator()(FILE* file) const { std::fclose(file); }
+};
+
+using FilePtr = std::unique_ptr<FILE, FileCloser>;
+
+// A render file in the cache directory, for trimming.
+struct CacheFile
+{
+  std::string path;
+  int64_t used; // last write time, in platform units
+  uint64_t bytes;
+};
+
+bool IsCacheFileName(const char* name)
+{
+  const size_t length = std::strlen(name);
+  return length > 5 && std::strcmp(name + length - 5, ".samp") == 0;
+}
+
+// std::filesystem needs macOS 10.15, so the directory is read with the
+// platform calls.
+#if defined(_WIN32)
+
+// Appends the render files in directory. Returns false if it could not be
+// read.
+bool ListCacheFiles(const std::string& directory, std::vector<CacheFile>& files)
+{
+  WIN32_FIND_DATAA data;
+  HANDLE find = FindFirstFileA((directory + "/*.samp").c_str(), &data);
+  if (find == INVALID_HANDLE_VALUE)
+    return GetLastError() == ERROR_FILE_NOT_FOUND;
+
+  do
+  {
+    if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || !IsCacheFileName(data.cFileName))
+      continue;
+    const int64_t used = (int64_t(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    const uint64_t bytes = (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    files.push_back({directory + "/" + data.cFileName, used, bytes});
+  } while (FindNextFileA(find, &data));
+
+  FindClose(find);
+  return true;
+}
+
+// Sets the last write time of path to now. Failures are ignored.
+void TouchFile(const std::string& path)
+{
+  HANDLE file = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return;
+
+  FILETIME now;
+  GetSystemTimeAsFileTime(&now);
+  SetFileTime(file, nullptr, nullptr, &now);
+  CloseHandle(file);
+}
+
+#else
+
+bool ListCacheFiles(const std::string& directory, std::vector<CacheFile>& files)
+{
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr)
+    return false;
+
+  while (const dirent* entry = readdir(dir))
+  {
+    if (!IsCacheFileName(entry->d_name))
+      continue;
+
+    // another process may have removed it already
+    std::string path = directory + "/" + entry->d_name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+      continue;
+    files.push_back({std::move(path), int64_t(info.st_mtime), uint64_t(info.st_size)});
+  }
+
+  closedir(dir);
+  return true;
+}
+
+void TouchFile(const std::string& path) { utime(path.c_str(), nullptr); }
+
+#endif
+
+// Budget of the shared disk cache in bytes.
+uint64_t GetSharedBudget()
+{
+  uint64_t megabytes = kDefaultRenderCacheMB;
+
+  const char* value = std::getenv("SAM_RENDER_CACHE_MB");
+  if (value != nullptr && *value != '\0')
+  {
+    char* end = nullptr;
+    const unsigned long long parsed = std::strtoull(value, &end, 10);
+    if (end != value && *end == '\0')
+      megabytes = parsed;
+  }
+
+  return megabytes * 1024 * 1024;
+}
+} // namespace
+
+DiskCache::DiskCache(std::string directory, uint64_t budgetBytes)
+: mDirectory(std::move(directory))
+, mBudget(budgetBytes)
+{
+  Trim();
+}
+
+std::shared_ptr<const PhrasePCM> DiskCache::Load(const PhraseKey& key)
+{
+  FilePtr file(std::fopen(PathFor(key).c_str(), "rb"));
+  FileHeader header;
+  long fileSize = -1;
+
+  if (file && std::fseek(file.get(), 0, SEEK_END) == 0)
+  {
+    fileSize = std::ftell(file.get());
+    std::rewind(file.get());
+  }
+
+  // a damaged or foreign file must not make us allocate what it claims
+  if (fileSize < 0 || std::fread(&header, sizeof(header), 1, file.get()) != 1 || header.magic != kFileMagic
+      || header.version != kFileVersion || header.engine != EngineBuildId() || header.lexicon != key.lexicon
+      || header.speed != key.speed || header.pitch != key.pitch
+      || header.throat != key.throat || header.mouth != key.mouth || header.textLength != key.text.size()
+      || header.sampleCount == 0 || header.sampleOffset < sizeof(header) + uint64_t(header.textLength)
+      || uint64_t(header.sampleOffset) + header.sampleCount > uint64_t(fileSize))
+  {
+    mMisses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  // the hash in the name may collide, the text may not
+  std::shared_ptr<PhrasePCM> pcm;
+  try
+  {
+    std::string text(header.textLength, '\0');
+    pcm = std::make_shared<PhrasePCM>();
+    pcm->samples.resize(header.sampleCount);
+    pcm->dcBias = header.dcBias;
+
+    if (std::fread(&text[0], 1, text.size(), file.get()) != text.size() || text != key.text
+        || std::fseek(file.get(), static_cast<long>(header.sampleOffset), SEEK_SET) != 0
+        || std::fread(pcm->samples.data(), 1, pcm->samples.size(), file.get()) != pcm->samples.size())
+      pcm = nullptr;
+  }
+  catch (const std::bad_alloc&)
+  {
+    pcm = nullptr;
+  }
+
+  if (!pcm)
+  {
+    mMisses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  // recently used files are the last to be trimmed
+  TouchFile(PathFor(key));
+
+  mLoads.fetch_add(1, std::memory_order_relaxed);
+  return pcm;
+}
+
+void DiskCache::Store(const PhraseKey& key, const PhrasePCM& pcm)
+{
+  FileHeader header;
+  header.magic = kFileMagic;
+  header.version = kFileVersion;
+  header.engine = EngineBuildId();
+  header.lexicon = key.lexicon;
+  header.speed = key.speed;
+  header.pitch = key.pitch;
+  header.throat = key.throat;
+  header.mouth = key.mouth;
+  header.textLength = static_cast<uint32_t>(key.text.size());
+  header.sampleOffset = AlignUp(static_cast<uint32_t>(sizeof(header) + key.text.size()));
+  header.sampleCount = static_cast<uint32_t>(pcm.samples.size());
+  header.dcBias = pcm.dcBias;
+
+  const std::string path = PathFor(key);
+  const std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()))
+                               + "." + std::to_string(mTempCounter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+
+  const char padding[kFileAlignment] = {};
+  const size_t paddingSize = header.sampleOffset - sizeof(header) - key.text.size();
+
+  FilePtr file(std::fopen(tempPath.c_str(), "wb"));
+  bool written = file && std::fwrite(&header, sizeof(header), 1, file.get()) == 1
+                 && std::fwrite(key.text.data(), 1, key.text.size(), file.get()) == key.text.size()
+                 && std::fwrite(padding, 1, paddingSize, file.get()) == paddingSize
+                 && std::fwrite(pcm.samples.data(), 1, pcm.samples.size(), file.get()) == pcm.samples.size();
+
+  if (file)
+    written = std::fclose(file.release()) == 0 && written;
+
+  // rename does not replace an existing file everywhere; that file is the
+  // same render, so keeping it is fine
+  if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0)
+  {
+    std::remove(tempPath.c_str());
+    return;
+  }
+
+  mStores.fetch_add(1, std::memory_order_relaxed);
+
+  const uint64_t bytes = uint64_t(header.sampleOffset) + header.sampleCount;
+  if (mBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes > mBudget)
+    Trim();
+}
+
+DiskCacheStats DiskCache::GetStats() const
+{
+  DiskCacheStats stats;
+  stats.loads = mLoads.load(std::memory_order_relaxed);
+  stats.misses = mMisses.load(std::memory_order_relaxed);
+  stats.stores = mStores.load(std::memory_order_relaxed);
+  stats.evictions = mEvictions.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::string DiskCache::PathFor(const PhraseKey& key) const
+{
+  const int32_t values[] = {key.speed, key.pitch, key.throat, key.mouth};
+  const uint64_t ids[] = {EngineBuildId(), key.lexicon};
+  uint64_t hash = 0xcbf29ce484222325ull;
+  hash = HashBytes(hash, &kFileVersion, sizeof(kFileVersion));
+  hash = HashBytes(hash, ids, sizeof(ids));
+  hash = HashBytes(hash, values, sizeof(values));
+  hash = HashBytes(hash, key.text.data(), key.text.size());
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.samp", static_cast<unsigned long long>(hash));
+  return mDirectory + "/" + name;
+}
+
+void DiskCache::Trim()
+{
+  // one trim at a time is enough
+  std::unique_lock<std::mutex> lock(mTrimMutex, std::try_to_lock);
+  if (!lock.owns_lock())
+    return;
+
+  try
+  {
+    std::vector<CacheFile> files;
+    if (!ListCacheFiles(mDirectory, files))
+      return;
+
+    uint64_t total = 0;
+    for (const CacheFile& file : files)
+      total += file.bytes;
+
+    if (total > mBudget)
+    {
+      std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.used < b.used; });
+
+      const uint64_t target = mBudget / 100 * kTrimPercent;
+      for (const CacheFile& file : files)
+      {
+        if (total <= target)
+          break;
+
+        // another process may have removed or replaced it already
+        if (std::remove(file.path.c_str()) == 0)
+          mEvictions.fetch_add(1, std::memory_order_relaxed);
+        total -= file.bytes;
+      }
+    }
+
+    mBytes.store(total, std::memory_order_relaxed);
+  }
+  catch (const std::exception&)
+  {
+    // out of memory; the cache only saves work
+  }
+}
+
+DiskCache* GetSharedDiskCache()
+{
+  static const std::unique_ptr<DiskCache> sCache = []() -> std::unique_ptr<DiskCache> {
+    const char* directory = std::getenv("SAM_RENDER_CACHE_DIR");
+    if (directory == nullptr || *directory == '\0')
+      return nullptr;
+    return std::make_unique<DiskCache>(directory, GetSharedBudget());
+  }();
+  return sCache.get();
+}
+
+} // namespace sam_bridge
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "SAMPhraseCache.h"
+
+namespace sam_bridge {
+
+constexpr size_t kDefaultRenderCacheMB = 256; // SAM_RENDER_CACHE_MB overrides it
+
+struct DiskCacheStats
+{
+  uint64_t loads = 0;     // renders read from disk
+  uint64_t misses = 0;    // no usable file
+  uint64_t stores = 0;    // renders written
+  uint64_t evictions = 0; // files removed to stay within the budget
+};
+
+// Renders kept in a directory across sessions, one file per phrase named
+// after a hash of its key and the engine build, so files rendered by
+// another build of the engine are never used. The build id comes from a
+// hash of the engine sources, see plugin/CMakeLists.txt. A file is a fixed
+// header, the text and then the samples at an 8-byte aligned offset, so it
+// can be read in one go or mapped. Files are written under a temporary
+// name and renamed, so other threads and processes never see a partial
+// one. Once the files pass the budget, the least recently used are removed.
+// Safe on any thread.
+class DiskCache
+{
+public:
+  // directory must exist.
+  DiskCache(std::string directory, uint64_t budgetBytes);
+
+  DiskCache(const DiskCache&) = delete;
+  DiskCache& operator=(const DiskCache&) = delete;
+
+  // Returns the stored render of key, or nullptr.
+  std::shared_ptr<const PhrasePCM> Load(const PhraseKey& key);
+
+  // Stores a render. Failures are ignored: the cache only saves work.
+  void Store(const PhraseKey& key, const PhrasePCM& pcm);
+
+  DiskCacheStats GetStats() const;
+
+private:
+  std::string PathFor(const PhraseKey& key) const;
+  // Counts the files and removes the oldest while they exceed the budget.
+  void Trim();
+
+  const std::string mDirectory;
+  const uint64_t mBudget;
+
+  std::mutex mTrimMutex;
+  // bytes in the directory as of the last Trim(), plus what this process
+  // wrote since; other processes may have added more
+  std::atomic<uint64_t> mBytes{0};
+
+  std::atomic<uint64_t> mLoads{0};
+  std::atomic<uint64_t> mMisses{0};
+  std::atomic<uint64_t> mStores{0};
+  std::atomic<uint64_t> mEvictions{0};
+  std::atomic<uint64_t> mTempCounter{0};
+};
+
+// Disk cache in the directory named by SAM_RENDER_CACHE_DIR, shared by
+// every plugin instance in the process, or nullptr when that is not set.
+DiskCache* GetSharedDiskCache();
+
+} // namespace sam_bridge
@@ -0,0 +1,199 @@
+#include "SAMPhraseCache.h"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace sam_bridge {
+
+namespace {
+// How often a caller waiting for another thread's render looks at its own
+// cancel token.
+constexpr std::chrono::milliseconds kRenderWaitInterval{2};
+
+// Budget of the shared cache in bytes.
+size_t GetSharedBudget()
+{
+  size_t megabytes = kDefaultPhraseCacheMB;
+
+  const char* value = std::getenv("SAM_PHRASE_CACHE_MB");
+  if (value != nullptr && *value != '\0')
+  {
+    char* end = nullptr;
+    const unsigned long parsed = std::strtoul(value, &end, 10);
+    if (end != value && *end == '\0')
+      megabytes = static_cast<size_t>(parsed);
+  }
+
+  return megabytes * 1024 * 1024;
+}
+} // namespace
+
+size_t PhraseKeyHash::operator()(const PhraseKey& key) const
+{
+  size_t hash = std::hash<std::string>()(key.text);
+  for (int value : {key.speed, key.pitch, key.throat, key.mouth})
+    hash = hash * 31 + static_cast<size_t>(value);
+  return hash * 31 + static_cast<size_t>(key.lexicon);
+}
+
+PhraseCache::PhraseCache(size_t budgetBytes)
+: mBudget(budgetBytes)
+{
+}
+
+// Stands for a key in mRendering. Taking the key out again and waking the
+// callers waiting for it happens however the render ends, so they never
+// wait for a render that is gone.
+class PhraseCache::RenderingMark
+{
+public:
+  // cache.mMutex must be held.
+  RenderingMark(PhraseCache& cache, const PhraseKey& key)
+  : mCache(cache)
+  , mKey(key)
+  {
+    cache.mRendering.insert(key);
+  }
+
+  // cache.mMutex must not be held.
+  ~RenderingMark()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mCache.mMutex);
+      mCache.mRendering.erase(mKey);
+    }
+    mCache.mRendered.notify_all();
+  }
+
+  RenderingMark(const RenderingMark&) = delete;
+  RenderingMark& operator=(const RenderingMark&) = delete;
+
+private:
+  PhraseCache& mCache;
+  const PhraseKey& mKey;
+};
+
+std::shared_ptr<const PhrasePCM> PhraseCache::FindOrRender(const PhraseKey& key, const RenderCancelToken& cancel,
+                                                           const RenderFunc& render)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (true)
+  {
+    if (std::shared_ptr<const PhrasePCM> pcm = Find(key))
+      return pcm;
+
+    if (mRendering.count(key) == 0)
+      break;
+
+    // the render under way may fail or be cancelled, so look again
+    mRendered.wait_for(lock, kRenderWaitInterval);
+    if (cancel.IsCancelled())
+      return nullptr;
+  }
+
+  mMisses.fetch_add(1, std::memory_order_relaxed);
+
+  try
+  {
+    RenderingMark rendering(*this, key);
+    lock.unlock();
+
+    std::shared_ptr<const PhrasePCM> pcm = render();
+    if (pcm)
+    {
+      std::lock_guard<std::mutex> insertLock(mMutex);
+      Insert(key, pcm);
+    }
+    return pcm;
+  }
+  catch (...)
+  {
+    // out of memory or a disk cache error. The mark has been released, so
+    // the caller sees a failed render and waiting callers try again.
+    return nullptr;
+  }
+}
+
+std::shared_ptr<const PhrasePCM> PhraseCache::Find(const PhraseKey& key)
+{
+  auto found = mIndex.find(key);
+  if (found == mIndex.end())
+    return nullptr;
+
+  mEntries.splice(mEntries.begin(), mEntries, found->second);
+  mHits.fetch_add(1, std::memory_order_relaxed);
+  return found->second->second;
+}
+
+void PhraseCache::Insert(const PhraseKey& key, std::shared_ptr<const PhrasePCM> pcm)
+{
+  if (!pcm)
+    return;
+
+  auto found = mIndex.find(key);
+  if (found != mIndex.end())
+  {
+    mBytes -= EntryBytes(*found->second);
+    mEntries.erase(found->second);
+    mIndex.erase(found);
+  }
+
+  Entry entry(key, std::move(pcm));
+  const size_t bytes = EntryBytes(entry);
+
+  if (bytes <= mBudget)
+  {
+    while (mBytes + bytes > mBudget)
+    {
+      mBytes -= EntryBytes(mEntries.back());
+      mIndex.erase(mEntries.back().first);
+      mEntries.pop_back();
+    }
+
+    mEntries.push_front(std::move(entry));
+    try
+    {
+      mIndex.emplace(mEntries.front().first, mEntries.begin());
+    }
+    catch (...)
+    {
+      mEntries.pop_front();
+      throw;
+    }
+    mBytes += bytes;
+  }
+
+  UpdateStats();
+}
+
+PhraseCacheStats PhraseCache::GetStats() const
+{
+  PhraseCacheStats stats;
+  stats.entries = mStatEntries.load(std::memory_order_relaxed);
+  stats.bytes = mStatBytes.load(std::memory_order_relaxed);
+  stats.budget = mBudget;
+  stats.hits = mHits.load(std::memory_order_relaxed);
+  stats.misses = mMisses.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// Samples and text, plus the list node and index entry around them.
+size_t PhraseCache::EntryBytes(const Entry& entry)
+{
+  return entry.second->samples.size() + 2 * entry.first.text.size() + sizeof(Entry) + sizeof(PhrasePCM) + 64;
+}
+
+void PhraseCache::UpdateStats()
+{
+  mStatEntries.store(mEntries.size(), std::memory_order_relaxed);
+  mStatBytes.store(mBytes, std::memory_order_relaxed);
+}
+
+PhraseCache& GetSharedPhraseCache()
+{
+  static PhraseCache sCache(GetSharedBudget());
+  return sCache;
+}
+
+} // namespace sam_bridge
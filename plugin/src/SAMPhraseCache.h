@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "SAMBridge.h"
+
+namespace sam_bridge {
+
+constexpr size_t kDefaultPhraseCacheMB = 64; // SAM_PHRASE_CACHE_MB overrides it
+
+// Samples of one render. They are never modified once rendered, so the
+// render cache and any number of published phrases share them.
+struct PhrasePCM
+{
+  std::vector<uint8_t> samples; // unsigned 8-bit at 22.05kHz
+  float dcBias = 0.f;
+};
+
+// Everything a render depends on.
+struct PhraseKey
+{
+  std::string text;
+  int speed = 0;
+  int pitch = 0;
+  int throat = 0;
+  int mouth = 0;
+  uint64_t lexicon = 0; // GetLexiconHash()
+
+  bool operator==(const PhraseKey& other) const
+  {
+    return speed == other.speed && pitch == other.pitch && throat == other.throat && mouth == other.mouth
+           && lexicon == other.lexicon && text == other.text;
+  }
+};
+
+struct PhraseKeyHash
+{
+  size_t operator()(const PhraseKey& key) const;
+};
+
+struct PhraseCacheStats
+{
+  size_t entries = 0;
+  size_t bytes = 0;
+  size_t budget = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+// Least recently used renders, limited to a memory budget. Safe on any
+// thread. Renders are shared, not copied: one that is evicted while a
+// caller still holds it stays alive until the last holder lets go.
+class PhraseCache
+{
+public:
+  // Renders key. Runs on the calling thread without the cache locked and
+  // returns nullptr on failure.
+  using RenderFunc = std::function<std::shared_ptr<const PhrasePCM>()>;
+
+  explicit PhraseCache(size_t budgetBytes);
+
+  PhraseCache(const PhraseCache&) = delete;
+  PhraseCache& operator=(const PhraseCache&) = delete;
+
+  // Returns the cached render of key, or calls render and keeps its
+  // result. While one thread renders a key, others asking for it wait for
+  // that render instead of repeating it. A waiting caller gives up with
+  // nullptr once cancel fires. A render that throws, or whose result cannot
+  // be kept, counts as failed.
+  std::shared_ptr<const PhrasePCM> FindOrRender(const PhraseKey& key, const RenderCancelToken& cancel,
+                                                const RenderFunc& render);
+
+  PhraseCacheStats GetStats() const;
+
+private:
+  using Entry = std::pair<PhraseKey, std::shared_ptr<const PhrasePCM>>;
+
+  class RenderingMark;
+
+  std::shared_ptr<const PhrasePCM> Find(const PhraseKey& key);
+  void Insert(const PhraseKey& key, std::shared_ptr<const PhrasePCM> pcm);
+  static size_t EntryBytes(const Entry& entry);
+  void UpdateStats();
+
+  const size_t mBudget;
+
+  std::mutex mMutex; // guards everything below but the stats
+  std::condition_variable mRendered;
+  size_t mBytes = 0;
+  std::list<Entry> mEntries; // most recently used first
+  std::unordered_map<PhraseKey, std::list<Entry>::iterator, PhraseKeyHash> mIndex;
+  std::unordered_set<PhraseKey, PhraseKeyHash> mRendering;
+
+  std::atomic<size_t> mStatEntries{0};
+  std::atomic<size_t> mStatBytes{0};
+  std::atomic<uint64_t> mHits{0};
+  std::atomic<uint64_t> mMisses{0};
+};
+
+// Cache shared by every plugin instance in the process, so identical
+// phrases are rendered and stored once.
+PhraseCache& GetSharedPhraseCache();
+
+} // namespace sam_bridge
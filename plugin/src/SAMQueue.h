@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace sam_bridge {
+
+// Bounded queue for one producer thread and one consumer thread. Neither
+// side ever blocks or allocates: TryPush fails when the queue is full and
+// TryPop when it is empty.
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer thread only.
+  bool TryPush(const T& value)
+  {
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    if (head - mTail.load(std::memory_order_acquire) == Capacity)
+      return false;
+
+    mItems[head & (Capacity - 1)] = value;
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer thread only.
+  bool TryPop(T& value)
+  {
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (mHead.load(std::memory_order_acquire) == tail)
+      return false;
+
+    value = mItems[tail & (Capacity - 1)];
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::array<T, Capacity> mItems{};
+  // kept on separate cache lines so the two threads do not share one
+  alignas(64) std::atomic<size_t> mHead{0};
+  alignas(64) std::atomic<size_t> mTail{0};
+};
+
+} // namespace sam_bridge
@@ -0,0 +1,212 @@
+#include "SAMRenderWorker.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
+
+#include <climits>
+#include <new>
+
+namespace sam_bridge {
+
+#if defined(_WIN32)
+
+WakeSemaphore::WakeSemaphore()
+: mHandle(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr))
+{
+  if (mHandle == nullptr)
+    throw std::bad_alloc();
+}
+
+WakeSemaphore::~WakeSemaphore() { CloseHandle(static_cast<HANDLE>(mHandle)); }
+
+void WakeSemaphore::Post() { ReleaseSemaphore(static_cast<HANDLE>(mHandle), 1, nullptr); }
+
+void WakeSemaphore::Wait() { WaitForSingleObject(static_cast<HANDLE>(mHandle), INFINITE); }
+
+#elif defined(__APPLE__)
+
+// macOS has no unnamed POSIX semaphores
+WakeSemaphore::WakeSemaphore()
+: mHandle(dispatch_semaphore_create(0))
+{
+  if (mHandle == nullptr)
+    throw std::bad_alloc();
+}
+
+WakeSemaphore::~WakeSemaphore() { dispatch_release(static_cast<dispatch_semaphore_t>(mHandle)); }
+
+void WakeSemaphore::Post() { dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(mHandle)); }
+
+void WakeSemaphore::Wait() { dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(mHandle), DISPATCH_TIME_FOREVER); }
+
+#else
+
+WakeSemaphore::WakeSemaphore()
+: mHandle(new sem_t)
+{
+  if (sem_init(static_cast<sem_t*>(mHandle), 0, 0) != 0)
+  {
+    delete static_cast<sem_t*>(mHandle);
+    throw std::bad_alloc();
+  }
+}
+
+WakeSemaphore::~WakeSemaphore()
+{
+  sem_destroy(static_cast<sem_t*>(mHandle));
+  delete static_cast<sem_t*>(mHandle);
+}
+
+void WakeSemaphore::Post() { sem_post(static_cast<sem_t*>(mHandle)); }
+
+void WakeSemaphore::Wait()
+{
+  while (sem_wait(static_cast<sem_t*>(mHandle)) != 0 && errno == EINTR) {}
+}
+
+#endif
+
+RenderWorker::RenderWorker(RenderFunc render)
+: mRender(std::move(render))
+{
+  mThread = std::thread([this] { Run(); });
+}
+
+RenderWorker::~RenderWorker()
+{
+  mStop.store(true, std::memory_order_release);
+  mWake.Post();
+  mThread.join();
+
+  delete mPublished.exchange(nullptr, std::memory_order_acquire);
+  delete mAudioPhrase;
+  FreeRetired();
+}
+
+uint64_t RenderWorker::Request()
+{
+  // the post comes after the new count, so the worker sees it once awake
+  const uint64_t request = mRequested.fetch_add(1, std::memory_order_acq_rel) + 1;
+  mWake.Post();
+  return request;
+}
+
+uint64_t RenderWorker::LatestRequest() const
+{
+  return mRequested.load(std::memory_order_acquire);
+}
+
+bool RenderWorker::IsRendering() const
+{
+  return mFinished.load(std::memory_order_acquire) != mRequested.load(std::memory_order_acquire);
+}
+
+const RenderedPhrase* RenderWorker::TakeNewPhrase()
+{
+  RenderedPhrase* phrase = mPublished.exchange(nullptr, std::memory_order_acq_rel);
+  if (phrase == nullptr)
+    return nullptr;
+
+  if (mAudioPhrase != nullptr)
+  {
+    RenderedPhrase* head = mRetired.load(std::memory_order_relaxed);
+    do
+      mAudioPhrase->mRetiredNext = head;
+    while (!mRetired.compare_exchange_weak(head, mAudioPhrase, std::memory_order_release, std::memory_order_relaxed));
+    mWake.Post();
+  }
+
+  mAudioPhrase = phrase;
+  return phrase;
+}
+
+RenderStats RenderWorker::GetStats() const
+{
+  RenderStats stats;
+  stats.completed = mCompleted.load(std::memory_order_relaxed);
+  stats.cancelled = mCancelled.load(std::memory_order_relaxed);
+  stats.failed = mFailed.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void RenderWorker::Run()
+{
+  uint64_t handled = 0;
+
+  while (true)
+  {
+    // every post stands for a request, a retired phrase or the stop, and
+    // posts made while rendering wake the next wait straight away
+    mWake.Wait();
+
+    FreeRetired();
+
+    if (mStop.load(std::memory_order_acquire))
+      break;
+
+    const uint64_t requested = mRequested.load(std::memory_order_acquire);
+    if (requested == handled)
+      continue;
+
+    handled = requested;
+
+    // any later request makes this render stale
+    RenderCancelToken cancel;
+    cancel.generation = &mRequested;
+    cancel.started = handled;
+
+    std::unique_ptr<RenderedPhrase> phrase;
+    try
+    {
+      phrase = mRender(cancel);
+    }
+    catch (...)
+    {
+      // leaving the thread would terminate the host; count it as failed
+      phrase = nullptr;
+    }
+
+    if (phrase)
+    {
+      phrase->request = handled;
+      Publish(std::move(phrase));
+      mCompleted.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (cancel.IsCancelled())
+    {
+      mCancelled.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+      mFailed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    mFinished.store(handled, std::memory_order_release);
+  }
+}
+
+void RenderWorker::Publish(std::unique_ptr<RenderedPhrase> phrase)
+{
+  // a phrase still waiting here was never seen by the audio thread
+  delete mPublished.exchange(phrase.release(), std::memory_order_acq_rel);
+}
+
+void RenderWorker::FreeRetired()
+{
+  RenderedPhrase* phrase = mRetired.exchange(nullptr, std::memory_order_acquire);
+
+  while (phrase != nullptr)
+  {
+    RenderedPhrase* next = phrase->mRetiredNext;
+    delete phrase;
+    phrase = next;
+  }
+}
+
+} // namespace sam_bridge
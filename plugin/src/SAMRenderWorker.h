@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "SAMBridge.h"
+#include "SAMPhraseCache.h"
+
+namespace sam_bridge {
+
+// One rendered phrase handed to the audio thread. It is not modified once
+// the worker has published it, so the audio thread reads it without
+// locking. The samples may be shared with a render cache; the last
+// reference is always dropped on the worker thread.
+struct RenderedPhrase
+{
+  std::shared_ptr<const PhrasePCM> pcm; // never null once published
+  uint64_t request = 0; // newest Request() this render serves
+
+private:
+  friend class RenderWorker;
+  RenderedPhrase* mRetiredNext = nullptr;
+};
+
+// Renders the worker has finished with, by outcome.
+struct RenderStats
+{
+  uint64_t completed = 0;
+  uint64_t cancelled = 0; // superseded by a newer request before finishing
+  uint64_t failed = 0;
+};
+
+// Counting semaphore of the platform. Post never blocks and never takes a
+// lock, so the audio thread can wake the worker with it.
+class WakeSemaphore
+{
+public:
+  WakeSemaphore();
+  ~WakeSemaphore();
+
+  WakeSemaphore(const WakeSemaphore&) = delete;
+  WakeSemaphore& operator=(const WakeSemaphore&) = delete;
+
+  void Post();
+  // Blocks until a Post() that no earlier Wait() has consumed.
+  void Wait();
+
+private:
+  void* mHandle;
+};
+
+// Runs a plugin's renders on a thread of its own and hands the results to
+// the audio thread. The audio thread never waits for a render, never takes
+// a lock and never frees a phrase. A render still running when a newer one
+// is asked for is abandoned.
+class RenderWorker
+{
+public:
+  // Renders the plugin's current settings. Runs on the worker thread and
+  // returns nullptr if there is nothing to publish, which is also what it
+  // should do once cancel fires. A render that throws counts as failed.
+  using RenderFunc = std::function<std::unique_ptr<RenderedPhrase>(const RenderCancelToken& cancel)>;
+
+  explicit RenderWorker(RenderFunc render);
+  ~RenderWorker();
+
+  RenderWorker(const RenderWorker&) = delete;
+  RenderWorker& operator=(const RenderWorker&) = delete;
+
+  // Asks for a render and returns the number of the request. Requests
+  // made before the worker gets to them are served by a single render.
+  // Safe on any thread, including the audio thread.
+  uint64_t Request();
+
+  // Number of the newest request.
+  uint64_t LatestRequest() const;
+
+  // True from a Request() until the render it asked for has finished.
+  bool IsRendering() const;
+
+  // Audio thread only. Returns the phrase published since the last call,
+  // or nullptr if there is none. The phrase returned before stays valid
+  // until then and is handed back to the worker to be freed.
+  const RenderedPhrase* TakeNewPhrase();
+
+  RenderStats GetStats() const;
+
+private:
+  void Run();
+  void Publish(std::unique_ptr<RenderedPhrase> phrase);
+  void FreeRetired();
+
+  RenderFunc mRender;
+
+  std::atomic<uint64_t> mRequested{0};
+  std::atomic<uint64_t> mFinished{0};
+  std::atomic<bool> mStop{false};
+
+  std::atomic<uint64_t> mCompleted{0};
+  std::atomic<uint64_t> mCancelled{0};
+  std::atomic<uint64_t> mFailed{0};
+
+  // Newest phrase the audio thread has not taken yet.
+  std::atomic<RenderedPhrase*> mPublished{nullptr};
+  // Phrases the audio thread is done with, linked through mRetiredNext.
+  std::atomic<RenderedPhrase*> mRetired{nullptr};
+  // Phrase the audio thread is reading. Only used on the audio thread.
+  RenderedPhrase* mAudioPhrase = nullptr;
+
+  // posted for every request, retired phrase and stop; the worker sleeps
+  // on it whenever it has nothing to do
+  WakeSemaphore mWake;
+  std::thread mThread;
+};
+
+} // namespace sam_bridge
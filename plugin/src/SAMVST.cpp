@@ -2,8 +2,10 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <limits>
@@ -30,6 +32,26 @@ int32_t ClampNonNegativeInt32(int value)
 
   return static_cast<int32_t>(value);
 }
+
+// The pronunciation dictionary is shared by all instances, so only the
+// first one loads it.
+void LoadLexiconOnce()
+{
+  static const bool sLoaded = [] {
+    const char* path = std::getenv("SAM_LEXICON");
+    if (path == nullptr || *path == '\0')
+      return false;
+
+    if (!sam_bridge::LoadLexicon(path))
+    {
+      DBGMSG("SAMVST: could not load lexicon %s\n", path);
+      return false;
+    }
+    return true;
+  }();
+  (void)sLoaded;
+}
+
 } // namespace
 
 #define STB_TEXTEDIT_CHARTYPE char16_t
@@ -931,6 +953,8 @@ SAMVST::SAMVST(const InstanceInfo& info)
   GetParam(kThroat)->InitInt("Throat", kDefaultThroat, kSAMParamMin, kSAMParamMax, "");
   GetParam(kMouth)->InitInt("Mouth", kDefaultMouth, kSAMParamMin, kSAMParamMax, "");
 
+  LoadLexiconOnce();
+
 #if IPLUG_EDITOR
   mMakeGraphicsFunc = [&]() {
     return MakeGraphics(*this, PLUG_WIDTH, PLUG_HEIGHT, PLUG_FPS, GetScaleForScreen(PLUG_WIDTH, PLUG_HEIGHT));
@@ -1002,6 +1026,9 @@ SAMVST::SAMVST(const InstanceInfo& info)
     pGraphics->AttachControl(new ITextControl(controlsPane.ReduceFromTop(20.f), "Enter/Esc commit • Shift+Enter inserts CR",
       DEFAULT_TEXT.WithSize(13.f).WithFGColor(kUiPurpleLight).WithAlign(EAlign::Near).WithFont(kUIFontID), COLOR_TRANSPARENT));
 
+    pGraphics->AttachControl(new ITextControl(controlsPane.ReduceFromTop(20.f), "",
+      DEFAULT_TEXT.WithSize(13.f).WithFGColor(kUiPurpleLight).WithAlign(EAlign::Near).WithFont(kUIFontID), COLOR_TRANSPARENT), kCtrlTagCacheStatus);
+
     IRECT textTitleRow = textPane.ReduceFromTop(24.f);
     pGraphics->AttachControl(new ITextControl(textTitleRow, "Text Buffer",
       DEFAULT_TEXT.WithSize(14.f).WithFGColor(kUiPurpleLight).WithAlign(EAlign::Near).WithFont(kUIFontID), COLOR_TRANSPARENT));
@@ -1010,15 +1037,13 @@ SAMVST::SAMVST(const InstanceInfo& info)
     pGraphics->AttachControl(new SAMTextPanelControl(textPane.GetPadded(-2.f), "",
       [this](const char* text) {
         SetTextBuffer(text);
-        mNeedsRender.store(true, std::memory_order_release);
-        if (!RenderPhraseFromText())
-          DBGMSG("SAMVST: failed to render phrase after text commit\n");
+        RequestRender(true);
         SyncUIState();
       },
       [this](const char* text) {
-        // Keep phrase state current while typing; synth render happens on trigger/commit.
+        // Keep phrase state current while typing; OnIdle renders ahead once typing pauses.
         SetTextBuffer(text);
-        mNeedsRender.store(true, std::memory_order_release);
+        MarkEdited();
       }), kCtrlTagTextPanel);
 
     pGraphics->SetKeyHandlerFunc([pGraphics](const IKeyPress& key, bool isUp) {
@@ -1040,8 +1065,9 @@ SAMVST::SAMVST(const InstanceInfo& info)
 
 bool SAMVST::SerializeState(IByteChunk& chunk) const
 {
-  const bool triggerPending = mPlaybackTriggerPending.load(std::memory_order_acquire);
-  const int32_t triggerRequests = ClampNonNegativeInt32(mPlaybackTriggerRequests.load(std::memory_order_acquire));
+  const int requestCount = mPlaybackTriggerRequests.load(std::memory_order_acquire);
+  const bool triggerPending = mPlaybackTriggerAcks.load(std::memory_order_acquire) < requestCount;
+  const int32_t triggerRequests = ClampNonNegativeInt32(requestCount);
   const uint32_t flags = triggerPending ? kStateFlagPlaybackPending : 0u;
 
   std::string textCopy;
@@ -1080,16 +1106,15 @@ int SAMVST::UnserializeState(const IByteChunk& chunk, int startPos)
 
   if (pos >= 0 && stateMagic == kStateMagic && stateVersion == kStateVersion)
   {
-    const bool triggerPending = (flags & kStateFlagPlaybackPending) != 0u;
+    // A trigger still pending when the state was saved is acknowledged
+    // without playing, as the next block after loading used to do.
     const int requestCount = std::max(0, static_cast<int>(triggerRequests));
 
-    mPlaybackTriggerPending.store(triggerPending, std::memory_order_release);
     mPlaybackTriggerRequests.store(requestCount, std::memory_order_release);
-    mPlaybackTriggerAcks.store(std::max(0, requestCount - (triggerPending ? 1 : 0)), std::memory_order_release);
+    mPlaybackTriggerAcks.store(requestCount, std::memory_order_release);
 
     SetTextBuffer(text.Get());
 
-    mLastPlaybackAckSeen = -1;
 #if IPLUG_EDITOR
     SyncUIState();
 #endif
@@ -1110,12 +1135,10 @@ int SAMVST::UnserializeState(const IByteChunk& chunk, int startPos)
     {
       const int requestCount = std::max(0, legacyTriggerRequests);
 
-      mPlaybackTriggerPending.store(legacyTriggerPending, std::memory_order_release);
       mPlaybackTriggerRequests.store(requestCount, std::memory_order_release);
-      mPlaybackTriggerAcks.store(std::max(0, requestCount - (legacyTriggerPending ? 1 : 0)), std::memory_order_release);
+      mPlaybackTriggerAcks.store(requestCount, std::memory_order_release);
       SetTextBuffer(legacyText.Get());
 
-      mLastPlaybackAckSeen = -1;
 #if IPLUG_EDITOR
       SyncUIState();
 #endif
@@ -1133,9 +1156,8 @@ int SAMVST::UnserializeState(const IByteChunk& chunk, int startPos)
 
   const int paramPos = UnserializeParams(chunk, startPos);
 
-  mNeedsRender.store(true, std::memory_order_release);
-  if (!RenderPhraseFromText())
-    DBGMSG("SAMVST: failed to re-render phrase after state load\n");
+  // loading is not an edit: the phrase renders when it is first needed
+  mPreRenderPending.store(false, std::memory_order_release);
 
   return paramPos;
 }
@@ -1147,19 +1169,16 @@ void SAMVST::OnReset()
   if (mSAMReadIncrement <= 0.0)
     mSAMReadIncrement = sam_bridge::kSAMSourceSampleRate / 44100.0;
 
-  mNeedsRender.store(true, std::memory_order_release);
-  if (!RenderPhraseFromText())
-  {
-    mRenderedPCM.clear();
-    ResetPlaybackPosition();
-    DBGMSG("SAMVST: failed to render phrase on reset\n");
-  }
+  mPositionInterval = std::max(1, static_cast<int>(hostSampleRate / kPositionUpdatesPerSecond));
+
+  // the phrase is rendered at 22.05kHz whatever the host rate, so a reset
+  // leaves it as it is
 }
 
 void SAMVST::OnParamChange(int paramIdx)
 {
   if (paramIdx == kSpeed || paramIdx == kPitch || paramIdx == kThroat || paramIdx == kMouth)
-    mNeedsRender.store(true, std::memory_order_release);
+    MarkEdited();
 }
 
 #if IPLUG_EDITOR
@@ -1172,68 +1191,256 @@ void SAMVST::OnUIOpen()
 
 void SAMVST::OnIdle()
 {
-  const int ackCount = mPlaybackTriggerAcks.load(std::memory_order_acquire);
-  if (ackCount != mLastPlaybackAckSeen)
+  PlaybackEvent event;
+  bool changed = false;
+
+  while (mPlaybackEvents.TryPop(event))
+  {
+    switch (event.type)
+    {
+      case PlaybackEvent::Type::PhraseReady:
+        break;
+      case PlaybackEvent::Type::PlaybackStarted:
+      case PlaybackEvent::Type::Position:
+        mUIPlaying = true;
+        break;
+      case PlaybackEvent::Type::PlaybackFinished:
+        mUIPlaying = false;
+        break;
+    }
+
+    mUIPlayback = event;
+    changed = true;
+  }
+
+  // render ahead once edits have paused, so the next trigger finds the
+  // phrase waiting
+  if (mPreRenderPending.load(std::memory_order_acquire))
   {
-    mLastPlaybackAckSeen = ackCount;
-    UpdatePlaybackStatusText(true);
+    const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    const auto quiet = std::chrono::steady_clock::duration(now - mLastEditTime.load(std::memory_order_acquire));
+
+    if (quiet >= std::chrono::milliseconds(kPreRenderDelayMs))
+    {
+      mPreRenderPending.store(false, std::memory_order_release);
+      if (NeedsRender())
+        RequestRender(false);
+    }
+  }
+
+  const bool rendering = mPreRenderPending.load(std::memory_order_acquire) || mRenderWorker.IsRendering();
+  const int renderState = rendering ? kPhraseRendering : NeedsRender() ? kPhraseDeferred : kPhraseReady;
+  if (renderState != mUIRenderState)
+  {
+    const bool wasRendering = mUIRenderState == kPhraseRendering;
+    mUIRenderState = renderState;
+    changed = true;
+
+    if (wasRendering && !rendering)
+    {
+      const sam_bridge::RenderStats stats = mRenderWorker.GetStats();
+      DBGMSG("SAMVST: renders completed %llu, cancelled %llu, failed %llu\n",
+             static_cast<unsigned long long>(stats.completed),
+             static_cast<unsigned long long>(stats.cancelled),
+             static_cast<unsigned long long>(stats.failed));
+
+      if (const sam_bridge::DiskCache* disk = sam_bridge::GetSharedDiskCache())
+      {
+        const sam_bridge::DiskCacheStats diskStats = disk->GetStats();
+        DBGMSG("SAMVST: disk cache loads %llu, misses %llu, stores %llu\n",
+               static_cast<unsigned long long>(diskStats.loads),
+               static_cast<unsigned long long>(diskStats.misses),
+               static_cast<unsigned long long>(diskStats.stores));
+      }
+    }
+  }
+
+  if (changed)
+    UpdatePlaybackStatusText();
+
+  const sam_bridge::PhraseCacheStats cacheStats = sam_bridge::GetSharedPhraseCache().GetStats();
+  if (cacheStats.entries != mUICacheStats.entries || cacheStats.bytes != mUICacheStats.bytes)
+  {
+    mUICacheStats = cacheStats;
+    UpdateCacheStatusText();
   }
 }
 
 void SAMVST::RequestPlaybackTrigger()
 {
-  const int requestCount = mPlaybackTriggerRequests.fetch_add(1, std::memory_order_acq_rel) + 1;
-  mPlaybackTriggerPending.store(true, std::memory_order_release);
+  if (NeedsRender())
+    RequestRender(false);
 
-  const bool needRender = mNeedsRender.load(std::memory_order_acquire) || mRenderedPCM.empty();
-  if (needRender && !RenderPhraseFromText())
-  {
-    mNeedsRender.store(true, std::memory_order_release);
-    return;
-  }
-  ResetPlaybackPosition();
+  // ProcessBlock restarts playback, or the render asked for above does
+  // when it arrives
+  PlaybackCommand command;
+  command.type = PlaybackCommand::Type::Trigger;
+  command.trigger = mPlaybackTriggerRequests.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+  if (mPlaybackCommands.TryPush(command))
+    DBGMSG("SAMVST: playback trigger request #%d queued\n", command.trigger);
+  else
+    DBGMSG("SAMVST: playback command queue full, dropped trigger #%d\n", command.trigger);
+
+  UpdatePlaybackStatusText();
+}
+
+void SAMVST::RequestRender(bool playWhenReady)
+{
+  mRequestedGeneration.store(mSettingsGeneration.load(std::memory_order_acquire), std::memory_order_release);
+  mPreRenderPending.store(false, std::memory_order_release);
 
-  DBGMSG("SAMVST: playback trigger request #%d queued\n", requestCount);
-  UpdatePlaybackStatusText(false);
+  const uint64_t request = mRenderWorker.Request();
+  if (playWhenReady)
+    mPlayRequest.store(request, std::memory_order_release);
 }
 
-bool SAMVST::RenderPhraseFromText()
+// Safe on any thread, like NeedsRender.
+void SAMVST::MarkStale()
+{
+  mSettingsGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool SAMVST::NeedsRender() const
+{
+  return mRequestedGeneration.load(std::memory_order_acquire) != mSettingsGeneration.load(std::memory_order_acquire);
+}
+
+// Safe on any thread: hosts may change parameters from the audio thread.
+void SAMVST::MarkEdited()
+{
+  MarkStale();
+  mLastEditTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_release);
+  mPreRenderPending.store(true, std::memory_order_release);
+}
+
+// Runs on the render worker thread.
+std::unique_ptr<sam_bridge::RenderedPhrase> SAMVST::RenderPhraseFromText(const sam_bridge::RenderCancelToken& cancel)
 {
   std::string phrase = GetTextBuffer();
   if (phrase.empty())
     phrase = mFallbackPhrase;
 
-  std::vector<uint8_t> rendered;
-  const int speed = static_cast<int>(GetParam(kSpeed)->Value());
-  const int pitch = static_cast<int>(GetParam(kPitch)->Value());
-  const int throat = static_cast<int>(GetParam(kThroat)->Value());
-  const int mouth = static_cast<int>(GetParam(kMouth)->Value());
+  sam_bridge::PhraseKey key;
+  key.speed = static_cast<int>(GetParam(kSpeed)->Value());
+  key.pitch = static_cast<int>(GetParam(kPitch)->Value());
+  key.throat = static_cast<int>(GetParam(kThroat)->Value());
+  key.mouth = static_cast<int>(GetParam(kMouth)->Value());
+  key.lexicon = sam_bridge::GetLexiconHash();
+  key.text = phrase;
+
+  // text and settings rendered before, by this or any other instance,
+  // play without rendering again
+  auto rendered = std::make_unique<sam_bridge::RenderedPhrase>();
+  rendered->pcm = sam_bridge::GetSharedPhraseCache().FindOrRender(key, cancel, [&] {
+    // a render kept on disk by an earlier session needs no synthesis
+    sam_bridge::DiskCache* disk = sam_bridge::GetSharedDiskCache();
+    if (disk != nullptr)
+    {
+      if (std::shared_ptr<const sam_bridge::PhrasePCM> pcm = disk->Load(key))
+        return pcm;
+    }
 
-  if (!sam_bridge::RenderTextToPCM(phrase, speed, pitch, throat, mouth, rendered))
+    std::shared_ptr<const sam_bridge::PhrasePCM> pcm = RenderPCM(key, cancel);
+    if (pcm && disk != nullptr)
+      disk->Store(key, *pcm);
+    return pcm;
+  });
+
+  if (!rendered->pcm)
   {
-    mNeedsRender.store(true, std::memory_order_release);
-    return false;
+    // a newer request renders the current settings
+    if (cancel.IsCancelled())
+      return nullptr;
+
+    MarkStale();
+    DBGMSG("SAMVST: failed to render phrase \"%s\"\n", phrase.c_str());
+    return nullptr;
   }
 
-  mRenderedPCM = std::move(rendered);
+  return rendered;
+}
+
+// Runs on the render worker thread.
+std::shared_ptr<const sam_bridge::PhrasePCM> SAMVST::RenderPCM(const sam_bridge::PhraseKey& key,
+                                                               const sam_bridge::RenderCancelToken& cancel)
+{
+  auto pcm = std::make_shared<sam_bridge::PhrasePCM>();
+
+  if (!sam_bridge::RenderTextToPCM(key.text, key.speed, key.pitch, key.throat, key.mouth, pcm->samples, cancel)
+      || pcm->samples.empty())
+    return nullptr;
 
   double sum = 0.0;
-  for (uint8_t sample : mRenderedPCM)
+  for (uint8_t sample : pcm->samples)
     sum += U8ToFloat(sample);
 
-  mRenderedDCBias = mRenderedPCM.empty() ? 0.f : static_cast<float>(sum / static_cast<double>(mRenderedPCM.size()));
-  ResetPlaybackPosition();
-  mNeedsRender.store(false, std::memory_order_release);
+  pcm->dcBias = static_cast<float>(sum / static_cast<double>(pcm->samples.size()));
 
   DBGMSG("SAMVST: rendered phrase \"%s\" with %d samples @ %.0fHz source\n",
-         phrase.c_str(), static_cast<int>(mRenderedPCM.size()), sam_bridge::kSAMSourceSampleRate);
-  return !mRenderedPCM.empty();
+         key.text.c_str(), static_cast<int>(pcm->samples.size()), sam_bridge::kSAMSourceSampleRate);
+  return pcm;
+}
+
+void SAMVST::Trigger(int trigger)
+{
+  if (trigger > mPlaybackTriggerAcks.load(std::memory_order_relaxed))
+    mPlaybackTriggerAcks.store(trigger, std::memory_order_release);
+
+  // a render in progress starts playing when it arrives
+  if (mRenderWorker.IsRendering())
+  {
+    mWaitingTrigger = trigger;
+    mWaitingRequest = mRenderWorker.LatestRequest();
+    return;
+  }
+
+  TakeRenderedPhrase();
+  StartPlayback(trigger);
 }
 
-void SAMVST::ResetPlaybackPosition()
+// Audio thread. Switches to the newest phrase the worker has published.
+bool SAMVST::TakeRenderedPhrase()
+{
+  const sam_bridge::RenderedPhrase* phrase = mRenderWorker.TakeNewPhrase();
+  if (phrase == nullptr)
+    return false;
+
+  if (mIsPlaying)
+    StopPlayback();
+
+  mPhrase = phrase;
+  SendPlaybackEvent(PlaybackEvent::Type::PhraseReady);
+  return true;
+}
+
+void SAMVST::StartPlayback(int trigger)
 {
   mSAMReadPos = 0.0;
-  mIsPlaying = !mRenderedPCM.empty();
+  mPlayingTrigger = trigger;
+  mSamplesSincePosition = 0;
+  mIsPlaying = mPhrase != nullptr && !mPhrase->pcm->samples.empty();
+
+  if (mIsPlaying)
+    SendPlaybackEvent(PlaybackEvent::Type::PlaybackStarted);
+}
+
+void SAMVST::StopPlayback()
+{
+  mIsPlaying = false;
+  SendPlaybackEvent(PlaybackEvent::Type::PlaybackFinished);
+}
+
+void SAMVST::SendPlaybackEvent(PlaybackEvent::Type type)
+{
+  PlaybackEvent event;
+  event.type = type;
+  event.trigger = mPlayingTrigger;
+  event.position = static_cast<int>(mSAMReadPos);
+  event.length = mPhrase != nullptr ? static_cast<int>(mPhrase->pcm->samples.size()) : 0;
+
+  // the UI catches up with the next event if this one does not fit
+  mPlaybackEvents.TryPush(event);
 }
 
 float SAMVST::U8ToFloat(uint8_t v)
@@ -1243,29 +1450,30 @@ float SAMVST::U8ToFloat(uint8_t v)
 
 float SAMVST::ReadSAMSample()
 {
-  if (!mIsPlaying || mRenderedPCM.empty())
+  if (!mIsPlaying || mPhrase == nullptr || mPhrase->pcm->samples.empty())
     return 0.f;
 
-  const size_t size = mRenderedPCM.size();
+  const std::vector<uint8_t>& pcm = mPhrase->pcm->samples;
+  const size_t size = pcm.size();
   const size_t idx = static_cast<size_t>(mSAMReadPos);
 
   if (idx >= size)
   {
-    mIsPlaying = false;
+    StopPlayback();
     return 0.f;
   }
 
   const size_t nextIdx = (idx + 1 < size) ? idx + 1 : idx;
   const double frac = mSAMReadPos - static_cast<double>(idx);
 
-  const float s0 = U8ToFloat(mRenderedPCM[idx]);
-  const float s1 = U8ToFloat(mRenderedPCM[nextIdx]);
+  const float s0 = U8ToFloat(pcm[idx]);
+  const float s1 = U8ToFloat(pcm[nextIdx]);
   const float out = s0 + static_cast<float>((s1 - s0) * frac);
-  const float centeredOut = std::clamp(out - mRenderedDCBias, -1.f, 1.f);
+  const float centeredOut = std::clamp(out - mPhrase->pcm->dcBias, -1.f, 1.f);
 
   mSAMReadPos += mSAMReadIncrement;
   if (mSAMReadPos >= static_cast<double>(size))
-    mIsPlaying = false;
+    StopPlayback();
 
   return centeredOut;
 }
@@ -1278,7 +1486,7 @@ void SAMVST::SetTextBuffer(const char* text)
   if (mTextBuffer.size() > kMaxTextBufferLength)
     mTextBuffer.resize(kMaxTextBufferLength);
 
-  mNeedsRender.store(true, std::memory_order_release);
+  MarkStale();
 }
 
 std::string SAMVST::GetTextBuffer() const
@@ -1287,7 +1495,7 @@ std::string SAMVST::GetTextBuffer() const
   return mTextBuffer;
 }
 
-void SAMVST::UpdatePlaybackStatusText(bool acknowledged)
+void SAMVST::UpdatePlaybackStatusText()
 {
 #if IPLUG_EDITOR
   if (auto* pUI = GetUI())
@@ -1300,11 +1508,22 @@ void SAMVST::UpdatePlaybackStatusText(bool acknowledged)
         const int ackCount = mPlaybackTriggerAcks.load(std::memory_order_acquire);
         WDL_String text;
 
-        if (requestCount == 0)
+        if (mUIPlaying)
+        {
+          const double sourceRate = sam_bridge::kSAMSourceSampleRate;
+          const double position = mUIPlayback.position / sourceRate;
+          const double length = mUIPlayback.length / sourceRate;
+
+          if (mUIPlayback.trigger > 0)
+            text.SetFormatted(128, "Playing request #%d  %.1fs / %.1fs", mUIPlayback.trigger, position, length);
+          else
+            text.SetFormatted(128, "Playing  %.1fs / %.1fs", position, length);
+        }
+        else if (requestCount == 0)
         {
           text.Set("Playback idle");
         }
-        else if (acknowledged && ackCount >= requestCount)
+        else if (ackCount >= requestCount)
         {
           text.SetFormatted(128, "Playback request #%d acknowledged", ackCount);
         }
@@ -1313,13 +1532,41 @@ void SAMVST::UpdatePlaybackStatusText(bool acknowledged)
           text.SetFormatted(128, "Playback request #%d pending DSP ack", requestCount);
         }
 
+        // state of the phrase the next trigger plays
+        if (mUIRenderState == kPhraseRendering)
+          text.Append(" - rendering");
+        else if (mUIRenderState == kPhraseDeferred)
+          text.Append(" - renders on trigger");
+        else
+          text.Append(" - ready");
+
+        pTextControl->SetStr(text.Get());
+        pTextControl->SetDirty(false);
+      }
+    }
+  }
+#endif
+}
+
+void SAMVST::UpdateCacheStatusText()
+{
+#if IPLUG_EDITOR
+  if (auto* pUI = GetUI())
+  {
+    if (auto* pStatusControl = pUI->GetControlWithTag(kCtrlTagCacheStatus))
+    {
+      if (auto* pTextControl = pStatusControl->As<ITextControl>())
+      {
+        constexpr double kMegabyte = 1024.0 * 1024.0;
+        WDL_String text;
+        text.SetFormatted(128, "Shared cache %.1f / %.0f MB, %d phrases", mUICacheStats.bytes / kMegabyte,
+                          mUICacheStats.budget / kMegabyte, static_cast<int>(mUICacheStats.entries));
+
         pTextControl->SetStr(text.Get());
         pTextControl->SetDirty(false);
       }
     }
   }
-#else
-  (void) acknowledged;
 #endif
 }
 
@@ -1341,7 +1588,9 @@ void SAMVST::SyncUIState()
       }
     }
 
-    UpdatePlaybackStatusText(false);
+    UpdatePlaybackStatusText();
+    mUICacheStats = sam_bridge::GetSharedPhraseCache().GetStats();
+    UpdateCacheStatusText();
     pUI->SetAllControlsDirty();
   }
 }
@@ -1352,18 +1601,21 @@ void SAMVST::ProcessMidiMsg(const IMidiMsg& msg)
 {
   if (msg.StatusMsg() == IMidiMsg::kNoteOn && msg.Velocity() > 0)
   {
-    const bool needRender = mNeedsRender.load(std::memory_order_acquire) || mRenderedPCM.empty();
-    if (needRender && !RenderPhraseFromText())
-    {
-      mNeedsRender.store(true, std::memory_order_release);
-      return;
-    }
-
-    const int requestCount = mPlaybackTriggerRequests.fetch_add(1, std::memory_order_acq_rel) + 1;
-    mPlaybackTriggerPending.store(true, std::memory_order_release);
-    ResetPlaybackPosition();
+    // never render here: the worker does it and the note starts playing
+    // when the phrase arrives
+    if (NeedsRender())
+      RequestRender(false);
+
+    // played at its own sample of the coming block
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::Trigger;
+    command.trigger = mPlaybackTriggerRequests.fetch_add(1, std::memory_order_acq_rel) + 1;
+    command.offset = msg.mOffset;
+
+    if (!mNoteCommands.TryPush(command))
+      Trigger(command.trigger);
     DBGMSG("SAMVST: MIDI note-on retrigger #%d note=%d velocity=%d\n",
-           requestCount, msg.NoteNumber(), msg.Velocity());
+           command.trigger, msg.NoteNumber(), msg.Velocity());
   }
 }
 
@@ -1371,18 +1623,67 @@ void SAMVST::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
 {
   (void) inputs;
 
-  if (mPlaybackTriggerPending.exchange(false, std::memory_order_acq_rel))
-    mPlaybackTriggerAcks.fetch_add(1, std::memory_order_acq_rel);
+  // read before taking a phrase: once the worker is idle, everything it
+  // rendered has been published
+  const bool rendering = mRenderWorker.IsRendering();
+  const uint64_t playRequest = mPlayRequest.load(std::memory_order_acquire);
+  const bool playPending = playRequest > mPlayedRequest;
+
+  // a phrase rendered ahead waits until the one playing has finished
+  if (mWaitingTrigger != 0 || playPending || !mIsPlaying)
+    TakeRenderedPhrase();
+
+  const uint64_t rendered = mPhrase != nullptr ? mPhrase->request : 0;
+
+  if (mWaitingTrigger != 0 && (!rendering || rendered >= mWaitingRequest))
+  {
+    StartPlayback(mWaitingTrigger);
+    mWaitingTrigger = 0;
+  }
+  else if (playPending && (!rendering || rendered >= playRequest))
+  {
+    // only a text commit asks to play: its phrase plays once, unless the
+    // render failed. Reset and state load never start playback.
+    mPlayedRequest = playRequest;
+    if (rendered >= playRequest)
+      StartPlayback(0);
+  }
+
+  // UI triggers play from the start of the block
+  PlaybackCommand command;
+  while (mPlaybackCommands.TryPop(command))
+    Trigger(command.trigger);
 
   const double gain = GetParam(kOutputGain)->Value() * 0.01;
   const int nOutChans = NOutChansConnected();
 
+  bool notePending = mNoteCommands.TryPop(command);
+
   for (int s = 0; s < nFrames; ++s)
   {
+    while (notePending && command.offset <= s)
+    {
+      Trigger(command.trigger);
+      notePending = mNoteCommands.TryPop(command);
+    }
+
+    if (mIsPlaying && ++mSamplesSincePosition >= mPositionInterval)
+    {
+      mSamplesSincePosition = 0;
+      SendPlaybackEvent(PlaybackEvent::Type::Position);
+    }
+
     const sample mono = static_cast<sample>(ReadSAMSample() * static_cast<float>(gain));
 
     for (int c = 0; c < nOutChans; ++c)
       outputs[c][s] = mono;
   }
+
+  // note-ons at or past the end of the block
+  while (notePending)
+  {
+    Trigger(command.trigger);
+    notePending = mNoteCommands.TryPop(command);
+  }
 }
 #endif
@@ -2,11 +2,16 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
 #include "IPlug_include_in_plug_hdr.h"
+#include "SAMDiskCache.h"
+#include "SAMPhraseCache.h"
+#include "SAMQueue.h"
+#include "SAMRenderWorker.h"
 
 const int kNumPresets = 1;
 constexpr int kMaxTextBufferLength = 512;
@@ -21,6 +26,42 @@ constexpr uint32_t kStateMagic = 0x53414D53; // SAMS
 constexpr uint32_t kStateVersion = 1;
 constexpr uint32_t kStateFlagPlaybackPending = 1u << 0;
 
+constexpr size_t kPlaybackQueueSize = 256;
+constexpr size_t kNoteQueueSize = 64;
+constexpr int kPositionUpdatesPerSecond = 30;
+constexpr int kPreRenderDelayMs = 150; // quiet time after an edit before rendering ahead
+
+// UI thread to audio thread.
+struct PlaybackCommand
+{
+  enum class Type : uint8_t
+  {
+    Trigger
+  };
+
+  Type type = Type::Trigger;
+  int trigger = 0; // request number from mPlaybackTriggerRequests
+  int offset = 0;  // sample in the block, MIDI only
+};
+
+// Audio thread to UI thread. Positions and lengths are in samples of the
+// rendered phrase.
+struct PlaybackEvent
+{
+  enum class Type : uint8_t
+  {
+    PhraseReady,
+    PlaybackStarted,
+    PlaybackFinished,
+    Position
+  };
+
+  Type type = Type::PhraseReady;
+  int trigger = 0;
+  int position = 0;
+  int length = 0;
+};
+
 enum EParams
 {
   kOutputGain = 0,
@@ -31,10 +72,19 @@ enum EParams
   kNumParams
 };
 
+// What the status row says about the phrase the next trigger plays.
+enum EPhraseState
+{
+  kPhraseReady = 0,
+  kPhraseRendering,
+  kPhraseDeferred // stale, rendered when a trigger needs it
+};
+
 enum ECtrlTags
 {
   kCtrlTagPlaybackStatus = 0,
-  kCtrlTagTextPanel
+  kCtrlTagTextPanel,
+  kCtrlTagCacheStatus
 };
 
 using namespace iplug;
@@ -63,31 +113,74 @@ public:
 
 private:
   void RequestPlaybackTrigger();
-  bool RenderPhraseFromText();
-  void ResetPlaybackPosition();
+  void RequestRender(bool playWhenReady);
+  void MarkStale();
+  bool NeedsRender() const;
+  void MarkEdited();
+  bool TakeRenderedPhrase();
+  std::unique_ptr<sam_bridge::RenderedPhrase> RenderPhraseFromText(const sam_bridge::RenderCancelToken& cancel);
+  static std::shared_ptr<const sam_bridge::PhrasePCM> RenderPCM(const sam_bridge::PhraseKey& key,
+                                                                const sam_bridge::RenderCancelToken& cancel);
+  void Trigger(int trigger);
+  void StartPlayback(int trigger);
+  void StopPlayback();
+  void SendPlaybackEvent(PlaybackEvent::Type type);
   float ReadSAMSample();
   void SetTextBuffer(const char* text);
   std::string GetTextBuffer() const;
-  void UpdatePlaybackStatusText(bool acknowledged);
+  void UpdatePlaybackStatusText();
+  void UpdateCacheStatusText();
   static float U8ToFloat(uint8_t v);
 
 #if IPLUG_EDITOR
   void SyncUIState();
 #endif
 
-  std::atomic<bool> mPlaybackTriggerPending{false};
-  std::atomic<bool> mNeedsRender{true};
+  // Bumped by every change to the text or voice settings; the phrase is
+  // stale while mRequestedGeneration lags behind. Construction, reset and
+  // state load only bump it, so a burst of them costs no synthesis until
+  // a trigger or an edit asks for the phrase.
+  std::atomic<uint64_t> mSettingsGeneration{1};
+  std::atomic<uint64_t> mRequestedGeneration{0};
+  // set by edits, cleared once OnIdle has rendered ahead for them
+  std::atomic<bool> mPreRenderPending{false};
+  std::atomic<int64_t> mLastEditTime{0}; // steady_clock ticks
+  // request whose phrase starts playing when it arrives
+  std::atomic<uint64_t> mPlayRequest{0};
   std::atomic<int> mPlaybackTriggerRequests{0};
   std::atomic<int> mPlaybackTriggerAcks{0};
-  int mLastPlaybackAckSeen = -1;
+
+  sam_bridge::SPSCQueue<PlaybackCommand, kPlaybackQueueSize> mPlaybackCommands;
+  sam_bridge::SPSCQueue<PlaybackEvent, kPlaybackQueueSize> mPlaybackEvents;
+  // note-ons of the coming block, both ends on the audio thread
+  sam_bridge::SPSCQueue<PlaybackCommand, kNoteQueueSize> mNoteCommands;
+
+  // playback state as last reported by the audio thread, UI thread only
+  PlaybackEvent mUIPlayback;
+  bool mUIPlaying = false;
+  int mUIRenderState = -1; // EPhraseState, -1 until shown
+  sam_bridge::PhraseCacheStats mUICacheStats;
 
   mutable std::mutex mTextMutex;
   std::string mTextBuffer = "HELLO FROM SAM VST";
 
-  std::vector<uint8_t> mRenderedPCM;
-  float mRenderedDCBias = 0.f;
+  // Phrase being played, owned by mRenderWorker. Audio thread only, like
+  // the playback position.
+  const sam_bridge::RenderedPhrase* mPhrase = nullptr;
   double mSAMReadPos = 0.0;
   double mSAMReadIncrement = 0.5;
   bool mIsPlaying = false;
+  int mPlayingTrigger = 0;
+  int mWaitingTrigger = 0; // started when the render in progress arrives
+  uint64_t mWaitingRequest = 0;
+  uint64_t mPlayedRequest = 0; // last mPlayRequest handled
+  int mSamplesSincePosition = 0;
+  int mPositionInterval = 1470;
   const std::string mFallbackPhrase = "HELLO FROM SAM VST";
+
+  // Declared last so the worker thread is stopped before the state its
+  // renders read is destroyed.
+  sam_bridge::RenderWorker mRenderWorker{[this](const sam_bridge::RenderCancelToken& cancel) {
+    return RenderPhraseFromText(cancel);
+  }};
 };
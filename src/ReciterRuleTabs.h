@@ -0,0 +1,485 @@
+#ifndef RECITERRULETABS_H
+#define RECITERRULETABS_H
+
+// Every reciter rule in the order SamTextToPhonemes tries them, sections
+// 0-25 for the letters A-Z and 26 for punctuation and digits. bytes[Y] is
+// GetRuleByte(address, Y). Generated by tests/reciter_rules_test.c from
+// rules and rules2 in ReciterTabs.h, which must be included first.
+typedef struct
+{
+	const unsigned char *bytes;
+	unsigned short address;
+	unsigned char open;   // position of '('
+	unsigned char close;  // position of ')'
+	unsigned char equals; // position of '='
+} ReciterRule;
+
+#define RULE1(a) ((const unsigned char*)rules + ((a) - 32000)), (a)
+#define RULE2(a) ((const unsigned char*)rules2 + ((a) - 37541)), (a)
+
+const ReciterRule reciterRules[444] =
+{
+	{ RULE1(32001), 2, 5, 6 },
+	{ RULE1(32013), 1, 3, 5 },
+	{ RULE1(32020), 2, 6, 8 },
+	{ RULE1(32031), 2, 5, 7 },
+	{ RULE1(32041), 1, 4, 6 },
+	{ RULE1(32051), 3, 6, 8 },
+	{ RULE1(32063), 1, 3, 6 },
+	{ RULE1(32071), 1, 4, 5 },
+	{ RULE1(32079), 3, 7, 8 },
+	{ RULE1(32093), 1, 3, 7 },
+	{ RULE1(32103), 3, 8, 9 },
+	{ RULE1(32116), 2, 5, 7 },
+	{ RULE1(32125), 1, 7, 8 },
+	{ RULE1(32140), 3, 6, 8 },
+	{ RULE1(32151), 1, 3, 6 },
+	{ RULE1(32159), 1, 3, 8 },
+	{ RULE1(32169), 3, 5, 9 },
+	{ RULE1(32181), 2, 6, 7 },
+	{ RULE1(32191), 1, 5, 6 },
+	{ RULE1(32201), 3, 6, 8 },
+	{ RULE1(32213), 1, 4, 5 },
+	{ RULE1(32222), 1, 5, 6 },
+	{ RULE1(32232), 1, 4, 5 },
+	{ RULE1(32240), 1, 4, 5 },
+	{ RULE1(32248), 1, 4, 5 },
+	{ RULE1(32256), 3, 6, 8 },
+	{ RULE1(32266), 3, 7, 9 },
+	{ RULE1(32278), 1, 5, 6 },
+	{ RULE1(32288), 1, 4, 6 },
+	{ RULE1(32297), 3, 8, 9 },
+	{ RULE1(32312), 1, 6, 7 },
+	{ RULE1(32324), 1, 3, 6 },
+	{ RULE1(32333), 1, 5, 7 },
+	{ RULE1(32345), 1, 7, 8 },
+	{ RULE1(32362), 1, 3, 7 },
+	{ RULE1(32371), 1, 3, 7 },
+	{ RULE1(32380), 2, 5, 7 },
+	{ RULE1(32390), 2, 4, 6 },
+	{ RULE1(32398), 1, 3, 4 },
+	{ RULE1(32406), 2, 4, 6 },
+	{ RULE1(32416), 2, 5, 8 },
+	{ RULE1(32427), 1, 7, 8 },
+	{ RULE1(32443), 2, 7, 9 },
+	{ RULE1(32458), 2, 6, 8 },
+	{ RULE1(32471), 1, 7, 8 },
+	{ RULE1(32485), 1, 6, 7 },
+	{ RULE1(32497), 1, 3, 4 },
+	{ RULE1(32504), 2, 4, 6 },
+	{ RULE1(32514), 2, 5, 7 },
+	{ RULE1(32522), 3, 6, 7 },
+	{ RULE1(32530), 1, 5, 8 },
+	{ RULE1(32542), 1, 4, 5 },
+	{ RULE1(32549), 3, 6, 8 },
+	{ RULE1(32561), 1, 4, 6 },
+	{ RULE1(32569), 1, 4, 6 },
+	{ RULE1(32577), 1, 4, 7 },
+	{ RULE1(32586), 1, 6, 7 },
+	{ RULE1(32599), 1, 3, 5 },
+	{ RULE1(32605), 1, 4, 5 },
+	{ RULE1(32611), 1, 11, 12 },
+	{ RULE1(32634), 1, 5, 6 },
+	{ RULE1(32644), 1, 6, 7 },
+	{ RULE1(32655), 1, 6, 7 },
+	{ RULE1(32668), 1, 3, 4 },
+	{ RULE1(32675), 2, 4, 6 },
+	{ RULE1(32685), 2, 6, 8 },
+	{ RULE1(32701), 3, 7, 9 },
+	{ RULE1(32714), 3, 5, 7 },
+	{ RULE1(32722), 5, 7, 9 },
+	{ RULE1(32732), 2, 5, 8 },
+	{ RULE1(32743), 2, 5, 7 },
+	{ RULE1(32753), 2, 7, 8 },
+	{ RULE1(32765), 1, 6, 8 },
+	{ RULE1(32778), 1, 7, 8 },
+	{ RULE1(32794), 2, 6, 7 },
+	{ RULE1(32804), 2, 5, 7 },
+	{ RULE1(32814), 2, 5, 8 },
+	{ RULE1(32825), 1, 3, 4 },
+	{ RULE1(32830), 4, 6, 8 },
+	{ RULE1(32832), 2, 4, 6 },
+	{ RULE1(32843), 3, 5, 7 },
+	{ RULE1(32850), 4, 6, 8 },
+	{ RULE1(32858), 3, 5, 7 },
+	{ RULE1(32867), 2, 5, 7 },
+	{ RULE1(32875), 3, 5, 8 },
+	{ RULE1(32883), 1, 4, 7 },
+	{ RULE1(32894), 1, 3, 6 },
+	{ RULE1(32903), 1, 5, 7 },
+	{ RULE1(32916), 1, 5, 6 },
+	{ RULE1(32928), 3, 6, 8 },
+	{ RULE1(32938), 1, 7, 8 },
+	{ RULE1(32953), 1, 7, 8 },
+	{ RULE1(32968), 1, 4, 6 },
+	{ RULE1(32977), 1, 4, 5 },
+	{ RULE1(32984), 2, 7, 8 },
+	{ RULE1(32998), 3, 5, 7 },
+	{ RULE1(33005), 2, 5, 6 },
+	{ RULE1(33013), 1, 4, 5 },
+	{ RULE1(33021), 1, 3, 5 },
+	{ RULE1(33028), 4, 7, 9 },
+	{ RULE1(33040), 3, 5, 8 },
+	{ RULE1(33048), 3, 7, 9 },
+	{ RULE1(33060), 3, 9, 10 },
+	{ RULE1(33075), 1, 6, 7 },
+	{ RULE1(33086), 1, 4, 5 },
+	{ RULE1(33094), 1, 6, 7 },
+	{ RULE1(33105), 2, 6, 8 },
+	{ RULE1(33116), 1, 5, 6 },
+	{ RULE1(33125), 3, 6, 8 },
+	{ RULE1(33137), 1, 4, 7 },
+	{ RULE1(33147), 1, 4, 5 },
+	{ RULE1(33155), 1, 6, 7 },
+	{ RULE1(33165), 1, 4, 5 },
+	{ RULE1(33173), 2, 6, 7 },
+	{ RULE1(33183), 1, 4, 5 },
+	{ RULE1(33190), 1, 4, 5 },
+	{ RULE1(33199), 1, 7, 8 },
+	{ RULE1(33214), 1, 3, 4 },
+	{ RULE1(33222), 2, 4, 6 },
+	{ RULE1(33232), 1, 5, 6 },
+	{ RULE1(33242), 1, 8, 9 },
+	{ RULE1(33258), 1, 8, 9 },
+	{ RULE1(33275), 1, 3, 5 },
+	{ RULE1(33280), 1, 3, 4 },
+	{ RULE1(33287), 2, 4, 6 },
+	{ RULE1(33297), 1, 5, 6 },
+	{ RULE1(33308), 2, 4, 7 },
+	{ RULE1(33316), 1, 4, 6 },
+	{ RULE1(33326), 3, 8, 9 },
+	{ RULE1(33341), 1, 4, 5 },
+	{ RULE1(33347), 4, 6, 7 },
+	{ RULE1(33355), 1, 3, 5 },
+	{ RULE1(33361), 1, 7, 8 },
+	{ RULE1(33375), 1, 5, 7 },
+	{ RULE1(33387), 2, 5, 6 },
+	{ RULE1(33393), 2, 5, 6 },
+	{ RULE1(33400), 1, 3, 4 },
+	{ RULE1(33407), 2, 4, 6 },
+	{ RULE1(33418), 2, 6, 7 },
+	{ RULE1(33431), 2, 7, 8 },
+	{ RULE1(33444), 2, 7, 8 },
+	{ RULE1(33457), 1, 5, 6 },
+	{ RULE1(33467), 1, 3, 5 },
+	{ RULE1(33474), 1, 3, 4 },
+	{ RULE1(33480), 2, 5, 6 },
+	{ RULE1(33489), 2, 4, 6 },
+	{ RULE1(33498), 1, 3, 5 },
+	{ RULE1(33505), 1, 4, 6 },
+	{ RULE1(33515), 4, 6, 7 },
+	{ RULE1(33524), 5, 7, 8 },
+	{ RULE1(33534), 1, 5, 6 },
+	{ RULE1(33544), 4, 8, 10 },
+	{ RULE1(33557), 1, 5, 7 },
+	{ RULE1(33568), 1, 5, 6 },
+	{ RULE1(33579), 1, 4, 6 },
+	{ RULE1(33590), 1, 4, 5 },
+	{ RULE1(33598), 3, 5, 8 },
+	{ RULE1(33609), 3, 6, 8 },
+	{ RULE1(33620), 1, 3, 5 },
+	{ RULE1(33627), 1, 4, 5 },
+	{ RULE1(33635), 2, 7, 8 },
+	{ RULE1(33651), 1, 3, 8 },
+	{ RULE1(33661), 1, 4, 6 },
+	{ RULE1(33670), 1, 4, 6 },
+	{ RULE1(33679), 1, 4, 6 },
+	{ RULE1(33688), 3, 5, 8 },
+	{ RULE1(33698), 3, 5, 8 },
+	{ RULE1(33708), 4, 6, 9 },
+	{ RULE1(33719), 1, 3, 6 },
+	{ RULE1(33727), 1, 4, 5 },
+	{ RULE1(33734), 1, 5, 6 },
+	{ RULE1(33743), 1, 5, 6 },
+	{ RULE1(33754), 2, 6, 7 },
+	{ RULE1(33765), 1, 5, 7 },
+	{ RULE1(33776), 1, 5, 7 },
+	{ RULE1(33787), 1, 5, 7 },
+	{ RULE1(33798), 1, 6, 7 },
+	{ RULE1(33812), 1, 6, 7 },
+	{ RULE1(33823), 1, 3, 4 },
+	{ RULE1(33831), 2, 4, 6 },
+	{ RULE1(33841), 1, 3, 4 },
+	{ RULE1(33848), 2, 4, 6 },
+	{ RULE1(33858), 2, 4, 6 },
+	{ RULE1(33864), 1, 3, 4 },
+	{ RULE1(33871), 2, 4, 6 },
+	{ RULE1(33881), 1, 4, 7 },
+	{ RULE1(33891), 2, 4, 5 },
+	{ RULE1(33896), 4, 6, 8 },
+	{ RULE1(33906), 1, 6, 7 },
+	{ RULE1(33917), 2, 8, 9 },
+	{ RULE1(33931), 1, 3, 4 },
+	{ RULE1(33938), 2, 4, 6 },
+	{ RULE1(33948), 2, 6, 8 },
+	{ RULE1(33964), 2, 6, 7 },
+	{ RULE1(33976), 2, 7, 9 },
+	{ RULE1(33993), 1, 5, 6 },
+	{ RULE1(34004), 1, 8, 9 },
+	{ RULE1(34022), 2, 4, 5 },
+	{ RULE1(34027), 1, 3, 4 },
+	{ RULE1(34034), 2, 4, 6 },
+	{ RULE1(34044), 2, 5, 7 },
+	{ RULE1(34053), 1, 4, 6 },
+	{ RULE1(34062), 1, 4, 6 },
+	{ RULE1(34071), 1, 5, 7 },
+	{ RULE1(34083), 1, 4, 5 },
+	{ RULE1(34090), 1, 4, 5 },
+	{ RULE1(34098), 2, 6, 8 },
+	{ RULE1(34110), 2, 4, 5 },
+	{ RULE1(34115), 1, 5, 7 },
+	{ RULE1(34127), 1, 3, 4 },
+	{ RULE1(34134), 2, 4, 6 },
+	{ RULE1(34144), 1, 4, 6 },
+	{ RULE1(34153), 2, 5, 7 },
+	{ RULE1(34163), 1, 8, 9 },
+	{ RULE1(34177), 3, 6, 8 },
+	{ RULE1(34187), 3, 7, 9 },
+	{ RULE1(34199), 1, 4, 5 },
+	{ RULE1(34207), 2, 6, 7 },
+	{ RULE1(34218), 2, 6, 8 },
+	{ RULE1(34230), 1, 4, 5 },
+	{ RULE1(34237), 2, 7, 8 },
+	{ RULE1(34251), 3, 5, 7 },
+	{ RULE1(34261), 1, 4, 5 },
+	{ RULE1(34270), 1, 3, 6 },
+	{ RULE1(34279), 1, 3, 7 },
+	{ RULE1(34288), 1, 3, 7 },
+	{ RULE1(34298), 1, 4, 6 },
+	{ RULE1(34308), 1, 7, 8 },
+	{ RULE1(34320), 1, 6, 7 },
+	{ RULE1(34331), 2, 5, 6 },
+	{ RULE1(34339), 2, 5, 8 },
+	{ RULE1(34350), 1, 5, 6 },
+	{ RULE1(34359), 1, 5, 6 },
+	{ RULE1(34368), 1, 6, 7 },
+	{ RULE1(34379), 1, 4, 7 },
+	{ RULE1(34389), 1, 5, 6 },
+	{ RULE1(34399), 1, 4, 5 },
+	{ RULE1(34406), 1, 4, 5 },
+	{ RULE1(34413), 1, 6, 7 },
+	{ RULE1(34427), 1, 4, 5 },
+	{ RULE1(34435), 1, 5, 6 },
+	{ RULE1(34445), 1, 5, 6 },
+	{ RULE1(34455), 2, 6, 7 },
+	{ RULE1(34466), 2, 6, 7 },
+	{ RULE1(34477), 2, 6, 7 },
+	{ RULE1(34488), 1, 5, 6 },
+	{ RULE1(34498), 2, 6, 7 },
+	{ RULE1(34509), 1, 4, 5 },
+	{ RULE1(34517), 1, 4, 5 },
+	{ RULE1(34524), 1, 3, 5 },
+	{ RULE1(34531), 1, 3, 5 },
+	{ RULE1(34538), 1, 4, 5 },
+	{ RULE1(34546), 2, 7, 8 },
+	{ RULE1(34561), 2, 7, 8 },
+	{ RULE1(34575), 1, 6, 7 },
+	{ RULE1(34587), 2, 4, 6 },
+	{ RULE1(34595), 1, 3, 6 },
+	{ RULE1(34603), 4, 6, 8 },
+	{ RULE1(34613), 2, 5, 6 },
+	{ RULE1(34621), 3, 6, 7 },
+	{ RULE1(34630), 3, 6, 7 },
+	{ RULE1(34639), 1, 3, 6 },
+	{ RULE1(34647), 1, 4, 6 },
+	{ RULE1(34657), 1, 7, 8 },
+	{ RULE1(34672), 2, 4, 6 },
+	{ RULE1(34681), 3, 5, 8 },
+	{ RULE1(34692), 1, 5, 7 },
+	{ RULE1(34703), 4, 7, 8 },
+	{ RULE1(34714), 1, 3, 4 },
+	{ RULE1(34722), 2, 4, 6 },
+	{ RULE1(34732), 1, 4, 5 },
+	{ RULE1(34738), 1, 7, 8 },
+	{ RULE1(34753), 1, 5, 6 },
+	{ RULE1(34763), 1, 5, 7 },
+	{ RULE1(34774), 1, 3, 5 },
+	{ RULE1(34779), 1, 3, 5 },
+	{ RULE1(34784), 1, 3, 5 },
+	{ RULE1(34789), 1, 7, 8 },
+	{ RULE1(34808), 1, 3, 4 },
+	{ RULE1(34815), 2, 4, 6 },
+	{ RULE1(34826), 1, 6, 7 },
+	{ RULE1(34839), 1, 4, 5 },
+	{ RULE1(34846), 1, 3, 4 },
+	{ RULE1(34853), 2, 4, 6 },
+	{ RULE1(34863), 2, 5, 8 },
+	{ RULE1(34874), 1, 3, 5 },
+	{ RULE1(34879), 1, 3, 4 },
+	{ RULE1(34886), 2, 4, 6 },
+	{ RULE1(34896), 1, 4, 5 },
+	{ RULE1(34903), 2, 7, 8 },
+	{ RULE1(34915), 1, 6, 7 },
+	{ RULE1(34926), 2, 6, 8 },
+	{ RULE1(34938), 1, 5, 7 },
+	{ RULE1(34949), 2, 5, 7 },
+	{ RULE1(34960), 2, 6, 8 },
+	{ RULE1(34972), 2, 6, 7 },
+	{ RULE1(34981), 2, 4, 6 },
+	{ RULE1(34988), 1, 6, 7 },
+	{ RULE1(34999), 2, 7, 8 },
+	{ RULE1(35011), 1, 3, 5 },
+	{ RULE1(35016), 2, 4, 6 },
+	{ RULE1(35023), 5, 7, 9 },
+	{ RULE1(35033), 5, 7, 9 },
+	{ RULE1(35043), 2, 4, 6 },
+	{ RULE1(35050), 4, 6, 8 },
+	{ RULE1(35059), 3, 5, 7 },
+	{ RULE1(35067), 2, 6, 7 },
+	{ RULE1(35076), 1, 3, 6 },
+	{ RULE1(35082), 2, 5, 6 },
+	{ RULE1(35091), 2, 5, 7 },
+	{ RULE1(35101), 1, 6, 7 },
+	{ RULE1(35111), 1, 3, 4 },
+	{ RULE1(35118), 2, 4, 6 },
+	{ RULE1(35128), 2, 6, 9 },
+	{ RULE1(35141), 2, 6, 8 },
+	{ RULE1(35153), 1, 4, 6 },
+	{ RULE1(35162), 2, 7, 8 },
+	{ RULE1(35175), 2, 7, 9 },
+	{ RULE1(35189), 2, 7, 8 },
+	{ RULE1(35201), 2, 8, 9 },
+	{ RULE1(35215), 1, 6, 7 },
+	{ RULE1(35226), 1, 7, 8 },
+	{ RULE1(35239), 2, 7, 9 },
+	{ RULE1(35253), 2, 7, 9 },
+	{ RULE1(35267), 1, 7, 9 },
+	{ RULE1(35281), 2, 7, 8 },
+	{ RULE1(35294), 1, 9, 10 },
+	{ RULE1(35310), 1, 7, 8 },
+	{ RULE1(35323), 1, 8, 10 },
+	{ RULE1(35337), 1, 7, 8 },
+	{ RULE1(35351), 1, 6, 11 },
+	{ RULE1(35368), 1, 4, 8 },
+	{ RULE1(35380), 2, 7, 8 },
+	{ RULE1(35394), 1, 4, 5 },
+	{ RULE1(35401), 3, 7, 8 },
+	{ RULE1(35413), 2, 5, 8 },
+	{ RULE1(35423), 1, 4, 6 },
+	{ RULE1(35431), 1, 4, 6 },
+	{ RULE1(35439), 1, 6, 7 },
+	{ RULE1(35450), 1, 5, 7 },
+	{ RULE1(35461), 1, 4, 6 },
+	{ RULE1(35471), 2, 6, 7 },
+	{ RULE1(35481), 2, 4, 8 },
+	{ RULE1(35489), 1, 3, 4 },
+	{ RULE1(35496), 2, 4, 6 },
+	{ RULE1(35506), 2, 5, 7 },
+	{ RULE1(35517), 2, 5, 6 },
+	{ RULE1(35526), 2, 7, 8 },
+	{ RULE1(35540), 2, 5, 7 },
+	{ RULE1(35551), 1, 4, 6 },
+	{ RULE1(35562), 1, 4, 5 },
+	{ RULE1(35569), 1, 3, 6 },
+	{ RULE1(35577), 1, 3, 6 },
+	{ RULE1(35586), 1, 4, 5 },
+	{ RULE1(35594), 3, 5, 7 },
+	{ RULE1(35601), 2, 4, 6 },
+	{ RULE1(35607), 2, 4, 6 },
+	{ RULE1(35614), 3, 5, 6 },
+	{ RULE1(35623), 2, 4, 5 },
+	{ RULE1(35630), 1, 3, 4 },
+	{ RULE1(35639), 2, 4, 6 },
+	{ RULE1(35649), 1, 6, 7 },
+	{ RULE1(35661), 1, 3, 4 },
+	{ RULE1(35668), 2, 4, 6 },
+	{ RULE1(35684), 2, 7, 8 },
+	{ RULE1(35695), 1, 4, 7 },
+	{ RULE1(35705), 1, 4, 7 },
+	{ RULE1(35715), 1, 4, 6 },
+	{ RULE1(35724), 1, 4, 6 },
+	{ RULE1(35733), 1, 7, 8 },
+	{ RULE1(35746), 1, 6, 7 },
+	{ RULE1(35758), 1, 6, 7 },
+	{ RULE1(35770), 1, 5, 6 },
+	{ RULE1(35780), 1, 4, 5 },
+	{ RULE1(35787), 1, 5, 7 },
+	{ RULE1(35798), 1, 5, 6 },
+	{ RULE1(35808), 1, 5, 7 },
+	{ RULE1(35818), 1, 4, 5 },
+	{ RULE1(35824), 1, 5, 7 },
+	{ RULE1(35835), 1, 5, 7 },
+	{ RULE1(35846), 1, 5, 7 },
+	{ RULE1(35856), 1, 6, 7 },
+	{ RULE1(35869), 4, 8, 9 },
+	{ RULE1(35880), 1, 3, 4 },
+	{ RULE1(35887), 2, 4, 6 },
+	{ RULE1(35898), 2, 4, 5 },
+	{ RULE1(35904), 1, 3, 4 },
+	{ RULE1(35912), 2, 4, 6 },
+	{ RULE1(35922), 1, 7, 8 },
+	{ RULE1(35935), 2, 7, 8 },
+	{ RULE1(35947), 2, 6, 7 },
+	{ RULE1(35957), 2, 6, 7 },
+	{ RULE1(35968), 2, 4, 5 },
+	{ RULE1(35974), 2, 4, 5 },
+	{ RULE1(35981), 3, 7, 8 },
+	{ RULE1(35992), 4, 6, 7 },
+	{ RULE1(36001), 4, 6, 8 },
+	{ RULE1(36011), 3, 5, 7 },
+	{ RULE1(36020), 3, 5, 7 },
+	{ RULE1(36029), 3, 5, 10 },
+	{ RULE1(36041), 3, 5, 8 },
+	{ RULE1(36051), 1, 3, 4 },
+	{ RULE1(36059), 2, 4, 6 },
+	{ RULE1(36069), 1, 3, 4 },
+	{ RULE2(37544), 1, 3, 4 },
+	{ RULE2(37549), 1, 3, 5 },
+	{ RULE2(37565), 1, 3, 4 },
+	{ RULE2(37576), 1, 3, 4 },
+	{ RULE2(37589), 1, 3, 4 },
+	{ RULE2(37601), 1, 3, 4 },
+	{ RULE2(37615), 1, 3, 4 },
+	{ RULE2(37624), 1, 3, 4 },
+	{ RULE2(37628), 1, 3, 4 },
+	{ RULE2(37644), 1, 3, 4 },
+	{ RULE2(37655), 1, 3, 4 },
+	{ RULE2(37660), 2, 4, 6 },
+	{ RULE2(37667), 1, 3, 4 },
+	{ RULE2(37671), 1, 3, 4 },
+	{ RULE2(37681), 1, 3, 4 },
+	{ RULE2(37693), 1, 3, 4 },
+	{ RULE2(37705), 2, 6, 7 },
+	{ RULE2(37718), 2, 7, 8 },
+	{ RULE2(37733), 1, 3, 4 },
+	{ RULE2(37743), 2, 6, 7 },
+	{ RULE2(37758), 1, 3, 4 },
+	{ RULE2(37767), 2, 6, 7 },
+	{ RULE2(37780), 1, 3, 4 },
+	{ RULE2(37791), 1, 3, 4 },
+	{ RULE2(37801), 2, 6, 7 },
+	{ RULE2(37815), 1, 3, 4 },
+	{ RULE2(37825), 2, 5, 7 },
+	{ RULE2(37846), 1, 3, 4 },
+	{ RULE2(37857), 1, 3, 4 },
+	{ RULE2(37869), 2, 6, 7 },
+	{ RULE2(37881), 1, 3, 4 },
+	{ RULE2(37890), 1, 3, 4 },
+	{ RULE2(37900), 1, 3, 4 },
+	{ RULE2(37905), 1, 3, 4 },
+	{ RULE2(37910), 1, 3, 4 },
+	{ RULE2(37926), 1, 3, 4 },
+	{ RULE2(37939), 1, 3, 4 },
+	{ RULE2(37958), 1, 3, 4 },
+	{ RULE2(37963), 1, 3, 4 },
+	{ RULE2(37972), 1, 3, 4 },
+};
+
+#undef RULE1
+#undef RULE2
+
+const short reciterSectionStart[27] =
+{
+	0, 39, 47, 64, 78, 118, 124, 137, 144,
+	179, 181, 184, 191, 199, 210, 269, 279, 283,
+	287, 312, 344, 360, 363, 384, 387, 402, 404
+};
+
+const short reciterSectionEnd[27] =
+{
+	39, 47, 64, 78, 118, 124, 137, 144, 179,
+	181, 184, 191, 199, 210, 269, 279, 283, 287,
+	312, 344, 360, 363, 384, 387, 402, 404, 444
+};
+
+#endif
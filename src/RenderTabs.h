@@ -1,16 +1,16 @@
 #ifndef RENDERTABS_H
 #define RENDERTABS_H
 
-unsigned char tab48426[5] = { 0x18, 0x1A, 0x17, 0x17, 0x17 };
+const unsigned char tab48426[5] = { 0x18, 0x1A, 0x17, 0x17, 0x17 };
 
-unsigned char tab47492[] = 
+const unsigned char tab47492[] = 
 {
 	0 , 0 , 0xE0 , 0xE6 , 0xEC , 0xF3 , 0xF9 , 0 , 
 	6 , 0xC , 6
 };
 
 
-unsigned char amplitudeRescale[] = 
+const unsigned char amplitudeRescale[] = 
 {
 	0 , 1 , 2 , 2 , 2 , 3 , 3 , 4 ,
 	4 , 5 , 6 , 8 , 9 ,0xB ,0xD ,0xF, 0  //17 elements?
@@ -18,7 +18,7 @@ unsigned char amplitudeRescale[] =
 
 // Used to decide which phoneme's blend lengths. The candidate with the lower score is selected.
 // tab45856 
-unsigned char blendRank[] = 
+const unsigned char blendRank[] = 
 {
 	0 , 0x1F , 0x1F , 0x1F , 0x1F , 2 , 2 , 2 ,
 	2 , 2 , 2 , 2 , 2 , 2 , 5 , 5 ,
@@ -35,7 +35,7 @@ unsigned char blendRank[] =
 
 // Number of frames at the end of a phoneme devoted to interpolating to next phoneme's final value
 //tab45696
-unsigned char outBlendLength[] = 
+const unsigned char outBlendLength[] = 
 {
 	0 , 2 , 2 , 2 , 2 , 4 , 4 , 4 ,
 	4 , 4 , 4 , 4 , 4 , 4 , 4 , 4 ,
@@ -52,7 +52,7 @@ unsigned char outBlendLength[] =
 
 // Number of frames at beginning of a phoneme devoted to interpolating to phoneme's final value
 // tab45776
-unsigned char inBlendLength[] = 
+const unsigned char inBlendLength[] = 
 {
 	0 , 2 , 2 , 2 , 2 , 4 , 4 , 4 ,
 	4 , 4 , 4 , 4 , 4 , 4 , 4 , 4 ,
@@ -85,7 +85,7 @@ unsigned char inBlendLength[] =
 // 67: **    27          00011011
 // 70: **    25          00011001
 // tab45936
-unsigned char sampledConsonantFlags[] =
+const unsigned char sampledConsonantFlags[] =
 {
     0 , 0 , 0 , 0 , 0 , 0 , 0 , 0 ,
     0 , 0 , 0 , 0 , 0 , 0 , 0 , 0 ,
@@ -100,38 +100,60 @@ unsigned char sampledConsonantFlags[] =
 };
 
 
-//tab45056
-unsigned char freq1data[]=
-{
-	0x00 ,0x13 ,0x13 ,0x13 ,0x13 , 0xA , 0xE ,0x12
-	,  0x18 ,0x1A ,0x16 ,0x14 ,0x10 ,0x14 , 0xE ,0x12
-	,	0xE ,0x12 ,0x12 ,0x10 , 0xC , 0xE , 0xA ,0x12
-	,	0xE ,0xA  , 8  , 6  , 6  ,  6 ,  6 ,0x11
-	,	 6 , 6 , 6 , 6 ,0xE , 0x10 , 9 ,0xA
-	,	 8 ,0xA , 6 , 6 , 6 , 5 , 6 , 0
-	,  0x12 , 0x1A , 0x14 , 0x1A , 0x12 ,0xC , 6 , 6
-	,	 6 , 6 , 6 , 6 , 6 , 6 , 6 , 6
-	,	 6 , 6 , 6 , 6 , 6 , 6 , 6 , 6
-	,	 6 ,0xA ,0xA , 6 , 6 , 6 , 0x2C , 0x13
-};
+// F1 of every phoneme for mouth m, tab45056 with the voiced phonemes 5-29
+// and 48-53 scaled. mouthFreq1[128] is the original table.
+#define SC(m, f) ((((m) * (f)) >> 8) << 1) // hibyte(m * f) << 1
+#define FREQ1ROW(m) { \
+	0x00, 0x13, 0x13, 0x13, 0x13, SC(m,10), SC(m,14), SC(m,19), \
+	SC(m,24), SC(m,27), SC(m,23), SC(m,21), SC(m,16), SC(m,20), SC(m,14), SC(m,18), \
+	SC(m,14), SC(m,18), SC(m,18), SC(m,16), SC(m,13), SC(m,15), SC(m,11), SC(m,18), \
+	SC(m,14), SC(m,11), SC(m,9), SC(m,6), SC(m,6), SC(m,6), 0x06, 0x11, \
+	0x06, 0x06, 0x06, 0x06, 0x0E, 0x10, 0x09, 0x0A, \
+	0x08, 0x0A, 0x06, 0x06, 0x06, 0x05, 0x06, 0x00, \
+	SC(m,19), SC(m,27), SC(m,21), SC(m,27), SC(m,18), SC(m,13), 0x06, 0x06, \
+	0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, \
+	0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06, \
+	0x06, 0x0A, 0x0A, 0x06, 0x06, 0x06, 0x2C, 0x13 \
+}
 
-//tab451356
-unsigned char freq2data[]=
-{
-	0x00 , 0x43 , 0x43 , 0x43 , 0x43 , 0x54 , 0x48 , 0x42 ,
-	0x3E , 0x28 , 0x2C , 0x1E , 0x24 , 0x2C , 0x48 , 0x30 ,
-	0x24 , 0x1E , 0x32 , 0x24 , 0x1C , 0x44 , 0x18 , 0x32 ,
-	0x1E , 0x18 , 0x52 , 0x2E , 0x36 , 0x56 , 0x36 , 0x43 ,
-	0x49 , 0x4F , 0x1A , 0x42 , 0x49 , 0x25 , 0x33 , 0x42 ,
-	0x28 , 0x2F , 0x4F , 0x4F , 0x42 , 0x4F , 0x6E , 0x00 ,
-	0x48 , 0x26 , 0x1E , 0x2A , 0x1E , 0x22 , 0x1A , 0x1A ,
-	0x1A , 0x42 , 0x42 , 0x42 , 0x6E , 0x6E , 0x6E , 0x54 ,
-	0x54 , 0x54 , 0x1A , 0x1A , 0x1A , 0x42 , 0x42 , 0x42 ,
-	0x6D , 0x56 , 0x6D , 0x54 , 0x54 , 0x54 , 0x7F , 0x7F
-};
+// F2 of every phoneme for throat t, tab451356 with the voiced phonemes
+// 5-29 and 48-53 scaled. throatFreq2[128] is the original table.
+#define FREQ2ROW(t) { \
+	0x00, 0x43, 0x43, 0x43, 0x43, SC(t,84), SC(t,73), SC(t,67), \
+	SC(t,63), SC(t,40), SC(t,44), SC(t,31), SC(t,37), SC(t,45), SC(t,73), SC(t,49), \
+	SC(t,36), SC(t,30), SC(t,51), SC(t,37), SC(t,29), SC(t,69), SC(t,24), SC(t,50), \
+	SC(t,30), SC(t,24), SC(t,83), SC(t,46), SC(t,54), SC(t,86), 0x36, 0x43, \
+	0x49, 0x4F, 0x1A, 0x42, 0x49, 0x25, 0x33, 0x42, \
+	0x28, 0x2F, 0x4F, 0x4F, 0x42, 0x4F, 0x6E, 0x00, \
+	SC(t,72), SC(t,39), SC(t,31), SC(t,43), SC(t,30), SC(t,34), 0x1A, 0x1A, \
+	0x1A, 0x42, 0x42, 0x42, 0x6E, 0x6E, 0x6E, 0x54, \
+	0x54, 0x54, 0x1A, 0x1A, 0x1A, 0x42, 0x42, 0x42, \
+	0x6D, 0x56, 0x6D, 0x54, 0x54, 0x54, 0x7F, 0x7F \
+}
+
+#define FREQROWS4(R, n) R(n), R((n)+1), R((n)+2), R((n)+3)
+#define FREQROWS16(R, n) FREQROWS4(R, n), FREQROWS4(R, (n)+4), \
+	FREQROWS4(R, (n)+8), FREQROWS4(R, (n)+12)
+#define FREQROWS256(R) FREQROWS16(R, 0), FREQROWS16(R, 16), \
+	FREQROWS16(R, 32), FREQROWS16(R, 48), FREQROWS16(R, 64), \
+	FREQROWS16(R, 80), FREQROWS16(R, 96), FREQROWS16(R, 112), \
+	FREQROWS16(R, 128), FREQROWS16(R, 144), FREQROWS16(R, 160), \
+	FREQROWS16(R, 176), FREQROWS16(R, 192), FREQROWS16(R, 208), \
+	FREQROWS16(R, 224), FREQROWS16(R, 240)
+
+// SetMouthThroat picks one row of each, all contexts share them.
+const unsigned char mouthFreq1[256][80] = { FREQROWS256(FREQ1ROW) };
+const unsigned char throatFreq2[256][80] = { FREQROWS256(FREQ2ROW) };
+
+#undef FREQROWS256
+#undef FREQROWS16
+#undef FREQROWS4
+#undef FREQ2ROW
+#undef FREQ1ROW
+#undef SC
 
 //tab45216
-unsigned char freq3data[]=
+const unsigned char freq3data[]=
 {
 	0x00 , 0x5B , 0x5B , 0x5B , 0x5B , 0x6E , 0x5D , 0x5B ,
 	0x58 , 0x59 , 0x57 , 0x58 , 0x52 , 0x59 , 0x5D , 0x3E ,
@@ -145,7 +167,7 @@ unsigned char freq3data[]=
 	0x65 , 0x65 , 0x70 , 0x5E , 0x5E , 0x5E , 0x08 , 0x01   
 };
 
-unsigned char ampl1data[] = 
+const unsigned char ampl1data[] = 
 {
 	0 , 0 , 0 , 0 , 0 ,0xD ,0xD ,0xE ,
 	0xF ,0xF ,0xF ,0xF ,0xF ,0xC ,0xD ,0xC ,
@@ -159,7 +181,7 @@ unsigned char ampl1data[] =
 	0 ,0xC , 0 , 0 , 0 , 0 ,0xF ,0xF
 };
 
-unsigned char ampl2data[] = 
+const unsigned char ampl2data[] = 
 {
 	0 , 0 , 0 , 0 , 0 ,0xA ,0xB ,0xD ,
 	0xE ,0xD ,0xC ,0xC ,0xB , 9 ,0xB ,0xB ,
@@ -173,7 +195,7 @@ unsigned char ampl2data[] =
 	0 ,0xA , 0 , 0 ,0xA , 0 , 0 , 0
 };
 
-unsigned char ampl3data[] = 
+const unsigned char ampl3data[] = 
 {
 	0 , 0 , 0 , 0 , 0 , 8 , 7 , 8 ,
 	8 , 1 , 1 , 0 , 1 , 0 , 7 , 5 ,
@@ -189,44 +211,50 @@ unsigned char ampl3data[] =
 
 
 
+// One period of the sine, W(value, a) for each of its 256 bytes.
+#define SINUS(W, a) \
+	W(0x00, a), W(0x00, a), W(0x00, a), W(0x10, a), W(0x10, a), W(0x10, a), W(0x10, a), W(0x10, a), \
+	W(0x10, a), W(0x20, a), W(0x20, a), W(0x20, a), W(0x20, a), W(0x20, a), W(0x20, a), W(0x30, a), \
+	W(0x30, a), W(0x30, a), W(0x30, a), W(0x30, a), W(0x30, a), W(0x30, a), W(0x40, a), W(0x40, a), \
+	W(0x40, a), W(0x40, a), W(0x40, a), W(0x40, a), W(0x40, a), W(0x50, a), W(0x50, a), W(0x50, a), \
+	W(0x50, a), W(0x50, a), W(0x50, a), W(0x50, a), W(0x50, a), W(0x60, a), W(0x60, a), W(0x60, a), \
+	W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), \
+	W(0x60, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), \
+	W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), \
+	W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), \
+	W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), W(0x70, a), \
+	W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), \
+	W(0x60, a), W(0x60, a), W(0x60, a), W(0x60, a), W(0x50, a), W(0x50, a), W(0x50, a), W(0x50, a), \
+	W(0x50, a), W(0x50, a), W(0x50, a), W(0x50, a), W(0x40, a), W(0x40, a), W(0x40, a), W(0x40, a), \
+	W(0x40, a), W(0x40, a), W(0x40, a), W(0x30, a), W(0x30, a), W(0x30, a), W(0x30, a), W(0x30, a), \
+	W(0x30, a), W(0x30, a), W(0x20, a), W(0x20, a), W(0x20, a), W(0x20, a), W(0x20, a), W(0x20, a), \
+	W(0x10, a), W(0x10, a), W(0x10, a), W(0x10, a), W(0x10, a), W(0x10, a), W(0x00, a), W(0x00, a), \
+	W(0x00, a), W(0x00, a), W(0x00, a), W(0xF0, a), W(0xF0, a), W(0xF0, a), W(0xF0, a), W(0xF0, a), \
+	W(0xF0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), W(0xD0, a), \
+	W(0xD0, a), W(0xD0, a), W(0xD0, a), W(0xD0, a), W(0xD0, a), W(0xD0, a), W(0xC0, a), W(0xC0, a), \
+	W(0xC0, a), W(0xC0, a), W(0xC0, a), W(0xC0, a), W(0xC0, a), W(0xB0, a), W(0xB0, a), W(0xB0, a), \
+	W(0xB0, a), W(0xB0, a), W(0xB0, a), W(0xB0, a), W(0xB0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), \
+	W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), \
+	W(0xA0, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), \
+	W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), \
+	W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), \
+	W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), W(0x90, a), \
+	W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), \
+	W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xA0, a), W(0xB0, a), W(0xB0, a), W(0xB0, a), W(0xB0, a), \
+	W(0xB0, a), W(0xB0, a), W(0xB0, a), W(0xB0, a), W(0xC0, a), W(0xC0, a), W(0xC0, a), W(0xC0, a), \
+	W(0xC0, a), W(0xC0, a), W(0xC0, a), W(0xD0, a), W(0xD0, a), W(0xD0, a), W(0xD0, a), W(0xD0, a), \
+	W(0xD0, a), W(0xD0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), W(0xE0, a), \
+	W(0xF0, a), W(0xF0, a), W(0xF0, a), W(0xF0, a), W(0xF0, a), W(0xF0, a), W(0x00, a), W(0x00, a)
+
+#define WAVEBYTE(v, a) (v)
+
 //tab42240
-unsigned char sinus[] = 
-{
-	0x00 , 0x00 , 0x00 , 0x10 , 0x10 , 0x10 , 0x10 , 0x10 ,
-	0x10 , 0x20 , 0x20 , 0x20 , 0x20 , 0x20 , 0x20 , 0x30 ,
-	0x30 , 0x30 , 0x30 , 0x30 , 0x30 , 0x30 , 0x40 , 0x40 ,
-	0x40 , 0x40 , 0x40 , 0x40 , 0x40 , 0x50 , 0x50 , 0x50 ,
-	0x50 , 0x50 , 0x50 , 0x50 , 0x50 , 0x60 , 0x60 , 0x60 , 
-	0x60 , 0x60 , 0x60 , 0x60 , 0x60 , 0x60 , 0x60 , 0x60 ,
-	0x60 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 ,
-	0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 ,
-	0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 ,
-	0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 , 0x70 ,
-	0x60 , 0x60 , 0x60 , 0x60 , 0x60 , 0x60 , 0x60 , 0x60 ,
-	0x60 , 0x60 , 0x60 , 0x60 , 0x50 , 0x50 , 0x50 , 0x50 ,
-	0x50 , 0x50 , 0x50 , 0x50 , 0x40 , 0x40 , 0x40 , 0x40 ,
-	0x40 , 0x40 , 0x40 , 0x30 , 0x30 , 0x30 , 0x30 , 0x30 ,
-	0x30 , 0x30 , 0x20 , 0x20 , 0x20 , 0x20 , 0x20 , 0x20 ,
-	0x10 , 0x10 , 0x10 , 0x10 , 0x10 , 0x10 , 0x00 , 0x00 ,
-	0x00 , 0x00 , 0x00 , 0xF0 , 0xF0 , 0xF0 , 0xF0 , 0xF0 ,
-	0xF0 , 0xE0 , 0xE0 , 0xE0 , 0xE0 , 0xE0 , 0xE0 , 0xD0 ,
-	0xD0 , 0xD0 , 0xD0 , 0xD0 , 0xD0 , 0xD0 , 0xC0 , 0xC0 ,
-	0xC0 , 0xC0 , 0xC0 , 0xC0 , 0xC0 , 0xB0 , 0xB0 , 0xB0 ,
-	0xB0 , 0xB0 , 0xB0 , 0xB0 , 0xB0 , 0xA0 , 0xA0 , 0xA0 ,
-	0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 ,
-	0xA0 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 ,
-	0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 ,
-	0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 ,
-	0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 ,
-	0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xA0 ,
-	0xA0 , 0xA0 , 0xA0 , 0xA0 , 0xB0 , 0xB0 , 0xB0 , 0xB0 ,
-	0xB0 , 0xB0 , 0xB0 , 0xB0 , 0xC0 , 0xC0 , 0xC0 , 0xC0 ,
-	0xC0 , 0xC0 , 0xC0 , 0xD0 , 0xD0 , 0xD0 , 0xD0 , 0xD0 ,
-	0xD0 , 0xD0 , 0xE0 , 0xE0 , 0xE0 , 0xE0 , 0xE0 , 0xE0 ,
-	0xF0 , 0xF0 , 0xF0 , 0xF0 , 0xF0 , 0xF0 , 0x00 , 0x00 };
+const unsigned char sinus[] = { SINUS(WAVEBYTE, 0) };
+
+#undef WAVEBYTE
 
 //tab42496
-unsigned char rectangle[] = 
+const unsigned char rectangle[] = 
 {
 	0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 ,
 	0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 , 0x90 ,
@@ -264,7 +292,7 @@ unsigned char rectangle[] =
 
 
 //tab42752
-unsigned char multtable[] = 
+const unsigned char multtable[] = 
 {
 	0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 ,
 	0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 , 0x00 ,
@@ -300,8 +328,37 @@ unsigned char multtable[] =
 	0xFC , 0xFB , 0xFB , 0xFA , 0xFA , 0xF9 , 0xF9 , 0xF8   
 };
 
+// The formant waveforms multiplied by the amplitudes 0-15, so a formant
+// needs one lookup per tick. AMPMUL(v, a) is multtable[v | a] for a
+// waveform byte v, whose low nibble is always 0: the signed high nibble
+// times a, halved and rounded down.
+#define NIBBLE(v) ((v) < 0x80 ? (v) >> 4 : ((v) >> 4) - 16)
+#define HALVED(x) ((x) >= 0 ? (x) / 2 : -((1 - (x)) / 2))
+#define AMPMUL(v, a) (HALVED(NIBBLE(v) * (a)) & 0xFF)
+
+#define REPEAT8(x) x, x, x, x, x, x, x, x
+#define REPEAT128(x) REPEAT8(REPEAT8(x)), REPEAT8(REPEAT8(x))
+#define SINEROW(a) { SINUS(AMPMUL, a) }
+#define RECTANGLEROW(a) { REPEAT128(AMPMUL(0x90, a)), REPEAT128(AMPMUL(0x70, a)) }
+#define AMPROWS16(R) R(0), R(1), R(2), R(3), R(4), R(5), R(6), R(7), \
+	R(8), R(9), R(10), R(11), R(12), R(13), R(14), R(15)
+
+// multtable[sinus[phase] | a] and multtable[rectangle[phase] | a]
+const unsigned char sineAmplitude[16][256] = { AMPROWS16(SINEROW) };
+const unsigned char rectangleAmplitude[16][256] = { AMPROWS16(RECTANGLEROW) };
+
+#undef AMPROWS16
+#undef RECTANGLEROW
+#undef SINEROW
+#undef REPEAT128
+#undef REPEAT8
+#undef AMPMUL
+#undef HALVED
+#undef NIBBLE
+#undef SINUS
+
 //random data ?
-unsigned char sampleTable[0x500] =
+const unsigned char sampleTable[0x500] =
 {
 	//00
 
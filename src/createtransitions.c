@@ -1,6 +1,6 @@
-#include <stdio.h>
 #include <stdlib.h>
 #include "render.h"
+#include "samcontext.h"
 
 // CREATE TRANSITIONS
 //
@@ -36,70 +36,13 @@
 // pitch from the center of the current phoneme to the center of the next
 // phoneme.
 
-// From render.c
-extern unsigned char phonemeIndexOutput[60]; //tab47296
-extern unsigned char phonemeLengthOutput[60]; //tab47416
-
 // from RenderTabs.h
-extern unsigned char blendRank[];
-extern unsigned char outBlendLength[];
-extern unsigned char inBlendLength[];
-extern unsigned char pitches[];
-
-extern unsigned char frequency1[256];
-extern unsigned char frequency2[256];
-extern unsigned char frequency3[256];
-
-extern unsigned char amplitude1[256];
-extern unsigned char amplitude2[256];
-extern unsigned char amplitude3[256];
-
-//written by me because of different table positions.
-// mem[47] = ...
-// 168=pitches
-// 169=frequency1
-// 170=frequency2
-// 171=frequency3
-// 172=amplitude1
-// 173=amplitude2
-// 174=amplitude3
-unsigned char Read(unsigned char p, unsigned char Y)
-{
-	switch(p)
-	{
-	case 168: return pitches[Y];
-	case 169: return frequency1[Y];
-	case 170: return frequency2[Y];
-	case 171: return frequency3[Y];
-	case 172: return amplitude1[Y];
-	case 173: return amplitude2[Y];
-	case 174: return amplitude3[Y];
-	default: 
-		printf("Error reading from tables");
-		return 0;
-	}
-}
-
-void Write(unsigned char p, unsigned char Y, unsigned char value)
-{
-	switch(p)
-	{
-	case 168: pitches[Y]    = value; return;
-	case 169: frequency1[Y] = value; return;
-	case 170: frequency2[Y] = value; return;
-	case 171: frequency3[Y] = value; return;
-	case 172: amplitude1[Y] = value; return;
-	case 173: amplitude2[Y] = value; return;
-	case 174: amplitude3[Y] = value; return;
-	default:
-		printf("Error writing to tables\n");
-		return;
-	}
-}
-
+extern const unsigned char blendRank[];
+extern const unsigned char outBlendLength[];
+extern const unsigned char inBlendLength[];
 
-// linearly interpolate values
-void interpolate(unsigned char width, unsigned char table, unsigned char frame, char mem53)
+// linearly interpolate values of one frame track
+void interpolate(SamContext *ctx, unsigned char width, unsigned char *track, unsigned char frame, char mem53)
 {
     unsigned char sign      = (mem53 < 0);
     unsigned char remainder = abs(mem53) % width;
@@ -107,7 +50,12 @@ void interpolate(unsigned char width, unsigned char table, unsigned char frame,
 
     unsigned char error = 0;
     unsigned char pos   = width;
-    unsigned char val   = Read(table, frame) + div; 
+    unsigned char val   = track[frame] + div;
+    // frames frame+1 .. frame+width-1 are written, all 255 after it for a
+    // width of 0
+    int last = frame + (unsigned char)(width - 1);
+
+    if (last >= ctx->framesUsed) ctx->framesUsed = last < 256 ? last + 1 : 256;
 
     while(--pos) {
         error += remainder;
@@ -116,30 +64,48 @@ void interpolate(unsigned char width, unsigned char table, unsigned char frame,
             if (sign) val--;
             else if (val) val++; // if input is 0, we always leave it alone
         }
-        Write(table, ++frame, val); // Write updated value back to next frame.
+        track[++frame] = val; // Write updated value back to next frame.
         val += div;
     }
 }
 
-void interpolate_pitch(unsigned char pos, unsigned char mem49, unsigned char phase3) {
+void interpolate_pitch(SamContext *ctx, unsigned char pos, unsigned char mem49, unsigned char phase3) {
     // unlike the other values, the pitches[] interpolates from 
     // the middle of the current phoneme to the middle of the 
     // next phoneme
         
     // half the width of the current and next phoneme
-    unsigned char cur_width  = phonemeLengthOutput[pos] / 2;
-    unsigned char next_width = phonemeLengthOutput[pos+1] / 2;
+    unsigned char cur_width  = ctx->phonemeLengthOutput[pos] / 2;
+    unsigned char next_width = ctx->phonemeLengthOutput[pos+1] / 2;
     // sum the values
     unsigned char width = cur_width + next_width;
-    char pitch = pitches[next_width + mem49] - pitches[mem49- cur_width];
-    interpolate(width, 168, phase3, pitch);
+    // The first phoneme can be wider than where it ends and the last can
+    // end past frame 255. The original then read before or after
+    // pitches[], where its -O2 and -O0 gcc builds placed frequency1[].
+    int start = mem49 - cur_width;
+    int end = mem49 + next_width;
+    unsigned char from = start < 0 ? ctx->frequency1[256 + start] : ctx->pitches[start];
+    unsigned char to = end > 255 ? ctx->frequency1[end - 256] : ctx->pitches[end];
+    char pitch = to - from;
+    interpolate(ctx, width, ctx->pitches, phase3, pitch);
 }
 
 
-unsigned char CreateTransitions()
+unsigned char CreateTransitions(SamContext *ctx)
 {
+	// the tracks interpolated between phoneme centres (pitches) and over
+	// the blend frames (formants and amplitudes)
+	unsigned char *tracks[6];
 	unsigned char mem49 = 0; 
 	unsigned char pos = 0;
+
+	tracks[0] = ctx->frequency1;
+	tracks[1] = ctx->frequency2;
+	tracks[2] = ctx->frequency3;
+	tracks[3] = ctx->amplitude1;
+	tracks[4] = ctx->amplitude2;
+	tracks[5] = ctx->amplitude3;
+
 	while(1) {
 		unsigned char next_rank;
 		unsigned char rank;
@@ -149,8 +115,8 @@ unsigned char CreateTransitions()
 		unsigned char phase3;
 		unsigned char transition;
 
-		unsigned char phoneme      = phonemeIndexOutput[pos];
-		unsigned char next_phoneme = phonemeIndexOutput[pos+1];
+		unsigned char phoneme      = ctx->phonemeIndexOutput[pos];
+		unsigned char next_phoneme = ctx->phonemeIndexOutput[pos+1];
 
 		if (next_phoneme == 255) break; // 255 == end_token
 
@@ -174,33 +140,24 @@ unsigned char CreateTransitions()
 			phase2 = inBlendLength[phoneme];
 		}
 
-		mem49 += phonemeLengthOutput[pos]; 
+		mem49 += ctx->phonemeLengthOutput[pos]; 
 
 		speedcounter = mem49 + phase2;
 		phase3       = mem49 - phase1;
 		transition   = phase1 + phase2; // total transition?
 		
 		if (((transition - 2) & 128) == 0) {
-            unsigned char table = 169;
-            interpolate_pitch(pos, mem49, phase3);
-            while (table < 175) {
-                // tables:
-                // 168  pitches[]
-                // 169  frequency1
-                // 170  frequency2
-                // 171  frequency3
-                // 172  amplitude1
-                // 173  amplitude2
-                // 174  amplitude3
-                
-                char value = Read(table, speedcounter) - Read(table, phase3);
-                interpolate(transition, table, phase3, value);
-                table++;
+            int track;
+            interpolate_pitch(ctx, pos, mem49, phase3);
+            for (track = 0; track < 6; track++) {
+                unsigned char *values = tracks[track];
+                char value = values[speedcounter] - values[phase3];
+                interpolate(ctx, transition, values, phase3, value);
             }
         }
 		++pos;
 	} 
 
     // add the length of this phoneme
-    return mem49 + phonemeLengthOutput[pos];
+    return mem49 + ctx->phonemeLengthOutput[pos];
 }
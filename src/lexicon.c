@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lexicon.h"
+
+// All words and phonemes live in one copy of the file. Each entry is a
+// word and its phonemes, both 0 terminated in that copy, found through an
+// open addressing table of entry indices that is at most half full.
+typedef struct
+{
+	unsigned int hash;
+	int word;     // offset of the upper case word in text
+	int length;   // of the word
+	int phonemes; // offset of the phonemes in text
+} LexiconEntry;
+
+struct SamLexicon
+{
+	char *text;
+	LexiconEntry *entries;
+	int count;
+	int *slots; // entry index + 1, 0 for empty
+	unsigned int mask;
+};
+
+static char Upper(char c)
+{
+	return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+// FNV-1a over the upper case word
+static unsigned int HashWord(const char *word, int length)
+{
+	unsigned int h = 2166136261u;
+	int i;
+	for (i = 0; i < length; i++) {
+		h ^= (unsigned char)Upper(word[i]);
+		h *= 16777619u;
+	}
+	// the table index uses the low bits, which FNV mixes poorly for words
+	// that differ only in their last letters
+	h ^= h >> 15;
+	h *= 0x2c1b3c6du;
+	h ^= h >> 12;
+	return h;
+}
+
+// a is upper case already
+static int WordEquals(const char *a, const char *b, int length)
+{
+	int i;
+	for (i = 0; i < length; i++)
+		if (a[i] != Upper(b[i])) return 0;
+	return 1;
+}
+
+// Returns the slot holding word, or the empty slot where it belongs.
+static int FindSlot(const SamLexicon *lexicon, const char *word, int length, unsigned int hash)
+{
+	unsigned int i = hash & lexicon->mask;
+	while (1) {
+		int slot = lexicon->slots[i];
+		const LexiconEntry *e;
+		if (slot == 0) return i;
+		e = &lexicon->entries[slot - 1];
+		if (e->hash == hash && e->length == length &&
+			WordEquals(lexicon->text + e->word, word, length)) return i;
+		i = (i + 1) & lexicon->mask;
+	}
+}
+
+static int IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Builds the lexicon from text, a malloc'd buffer of length + 1 bytes
+// that the lexicon takes over.
+static SamLexicon* ParseLexicon(char *text, int length)
+{
+	SamLexicon *lexicon;
+	char *t;
+	unsigned int size = 16;
+	int lines = 1;
+	int pos = 0;
+	int i;
+
+	lexicon = calloc(1, sizeof(SamLexicon));
+	if (lexicon == NULL) {
+		free(text);
+		return NULL;
+	}
+	lexicon->text = text;
+	text[length] = 0;
+
+	for (t = memchr(text, '\n', length); t != NULL; t = memchr(t + 1, '\n', text + length - t - 1))
+		lines++;
+	while (size < 2u * lines) size *= 2;
+
+	lexicon->entries = malloc(lines * sizeof(LexiconEntry));
+	lexicon->slots = calloc(size, sizeof(int));
+	lexicon->mask = size - 1;
+	if (lexicon->entries == NULL || lexicon->slots == NULL) {
+		SamDestroyLexicon(lexicon);
+		return NULL;
+	}
+
+	// split the copy in place into 0 terminated words and phonemes
+	t = text;
+	while (pos < length) {
+		char *newline = memchr(t + pos, '\n', length - pos);
+		int word, wordEnd, phonemes;
+		int end = newline ? (int)(newline - t) : length;
+
+		word = pos;
+		while (word < end && IsBlank(t[word])) word++;
+		wordEnd = word;
+		while (wordEnd < end && !IsBlank(t[wordEnd])) wordEnd++;
+		phonemes = wordEnd;
+		while (phonemes < end && IsBlank(t[phonemes])) phonemes++;
+		i = end;
+		while (i > phonemes && IsBlank(t[i-1])) i--;
+
+		if (word < wordEnd && t[word] != '#' && phonemes < i) {
+			LexiconEntry *e = &lexicon->entries[lexicon->count];
+			int slot;
+
+			t[wordEnd] = 0;
+			t[i] = 0;
+			for (slot = word; slot < wordEnd; slot++)
+				t[slot] = Upper(t[slot]);
+
+			e->hash = HashWord(t + word, wordEnd - word);
+			e->word = word;
+			e->length = wordEnd - word;
+			e->phonemes = phonemes;
+
+			slot = FindSlot(lexicon, t + word, e->length, e->hash);
+			if (lexicon->slots[slot] == 0)
+				lexicon->slots[slot] = ++lexicon->count;
+			else
+				lexicon->entries[lexicon->slots[slot] - 1].phonemes = phonemes;
+		}
+		pos = end + 1;
+	}
+	return lexicon;
+}
+
+SamLexicon* SamParseLexicon(const char *text, int length)
+{
+	char *copy = malloc(length + 1);
+	if (copy == NULL) return NULL;
+	memcpy(copy, text, length);
+	return ParseLexicon(copy, length);
+}
+
+SamLexicon* SamLoadLexicon(const char *path)
+{
+	SamLexicon *lexicon = NULL;
+	FILE *file = fopen(path, "rb");
+	char *text;
+	long length;
+
+	if (file == NULL) return NULL;
+	if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+		text = malloc(length + 1);
+		if (text != NULL) {
+			if (fread(text, 1, length, file) == (size_t)length)
+				lexicon = ParseLexicon(text, (int)length);
+			else
+				free(text);
+		}
+	}
+	fclose(file);
+	return lexicon;
+}
+
+void SamDestroyLexicon(SamLexicon *lexicon)
+{
+	if (lexicon == NULL) return;
+	free(lexicon->text);
+	free(lexicon->entries);
+	free(lexicon->slots);
+	free(lexicon);
+}
+
+int SamLexiconSize(const SamLexicon *lexicon)
+{
+	return lexicon ? lexicon->count : 0;
+}
+
+const char* SamLexiconLookup(const SamLexicon *lexicon, const char *word, int length)
+{
+	int slot;
+	if (lexicon == NULL || length <= 0) return NULL;
+	slot = lexicon->slots[FindSlot(lexicon, word, length, HashWord(word, length))];
+	if (slot == 0) return NULL;
+	return lexicon->text + lexicon->entries[slot - 1].phonemes;
+}
@@ -0,0 +1,28 @@
+#ifndef LEXICON_H
+#define LEXICON_H
+
+// Pronunciation dictionary checked before the reciter rules. The file has
+// one entry per line: a word, then whitespace, then its SAM phonemes, e.g.
+//
+//   SAM      SAE4M
+//   IPLUG    AY4PLAHG
+//
+// Lines that are empty or start with '#' are ignored. Words are matched
+// case insensitively; later entries replace earlier ones.
+typedef struct SamLexicon SamLexicon;
+
+// Returns NULL if the file cannot be read.
+SamLexicon* SamLoadLexicon(const char *path);
+
+// Same as SamLoadLexicon for text already in memory. The text is copied.
+SamLexicon* SamParseLexicon(const char *text, int length);
+
+void SamDestroyLexicon(SamLexicon *lexicon);
+
+int SamLexiconSize(const SamLexicon *lexicon);
+
+// Returns the phonemes for word, which need not be upper case, or NULL.
+// The result stays valid until the lexicon is destroyed.
+const char* SamLexiconLookup(const SamLexicon *lexicon, const char *word, int length);
+
+#endif
@@ -1,36 +1,66 @@
 #include "render.h"
-
-extern unsigned char speed;
+#include "samcontext.h"
 
 // From RenderTabs.h
-extern unsigned char multtable[];
-extern unsigned char sinus[];
-extern unsigned char rectangle[];
-
-// From render.c
-extern unsigned char pitches[256]; 
-extern unsigned char sampledConsonantFlag[256]; // tab44800
-extern unsigned char amplitude1[256];
-extern unsigned char amplitude2[256];
-extern unsigned char amplitude3[256];
-extern unsigned char frequency1[256];
-extern unsigned char frequency2[256];
-extern unsigned char frequency3[256];
-
-extern void Output(int index, unsigned char A);
-
-static void CombineGlottalAndFormants(unsigned char phase1, unsigned char phase2, unsigned char phase3, unsigned char Y)
+extern const unsigned char multtable[];
+extern const unsigned char sinus[];
+extern const unsigned char rectangle[];
+extern const unsigned char sineAmplitude[16][256];
+extern const unsigned char rectangleAmplitude[16][256];
+
+// Combines the glottal pulse and the three formants of frame Y into one
+// output value per tick. The run is count ticks in which neither the
+// frame nor the glottal pulse ends, so the phases just keep advancing,
+// followed by the tick that ends it, whose phase update is left to the
+// caller. All values are computed in one go before they are output.
+// Stops early at bufferlimit and returns the number of ticks rendered.
+static int RenderFormantRun(SamContext *ctx, unsigned char Y, unsigned char *phases, int count, int bufferlimit)
 {
-    unsigned int tmp;
-
-    tmp   = multtable[sinus[phase1]     | amplitude1[Y]];
-    tmp  += multtable[sinus[phase2]     | amplitude2[Y]];
-    tmp  += tmp > 255 ? 1 : 0; // if addition above overflows, we for some reason add one;
-    tmp  += multtable[rectangle[phase3] | amplitude3[Y]];
-    tmp  += 136;
-    tmp >>= 4; // Scale down to 0..15 range of C64 audio.
-            
-    Output(0, tmp & 0xf);
+    unsigned char values[256];
+    unsigned char phase1 = phases[0];
+    unsigned char phase2 = phases[1];
+    unsigned char phase3 = phases[2];
+    unsigned char frequency1 = ctx->frequency1[Y];
+    unsigned char frequency2 = ctx->frequency2[Y];
+    unsigned char frequency3 = ctx->frequency3[Y];
+    unsigned char amplitude1 = ctx->amplitude1[Y];
+    unsigned char amplitude2 = ctx->amplitude2[Y];
+    unsigned char amplitude3 = ctx->amplitude3[Y];
+    int i, done;
+
+    count++; // the tick ending the run
+    if ((amplitude1 | amplitude2 | amplitude3) < 16) {
+        const unsigned char *sine1 = sineAmplitude[amplitude1];
+        const unsigned char *sine2 = sineAmplitude[amplitude2];
+        const unsigned char *rect3 = rectangleAmplitude[amplitude3];
+        for (i = 0; i < count; i++) {
+            unsigned int tmp = sine1[phase1] + sine2[phase2];
+            tmp += tmp > 255 ? 1 : 0;
+            tmp += rect3[phase3] + 136;
+            values[i] = (unsigned char)(tmp >> 4);
+            phase1 += frequency1;
+            phase2 += frequency2;
+            phase3 += frequency3;
+        }
+    } else {
+        // amplitudes above 15 overlap the waveform bits
+        for (i = 0; i < count; i++) {
+            unsigned int tmp = multtable[sinus[phase1] | amplitude1] + multtable[sinus[phase2] | amplitude2];
+            tmp += tmp > 255 ? 1 : 0;
+            tmp += multtable[rectangle[phase3] | amplitude3] + 136;
+            values[i] = (unsigned char)(tmp >> 4);
+            phase1 += frequency1;
+            phase2 += frequency2;
+            phase3 += frequency3;
+        }
+    }
+
+    done = OutputRun(ctx, values, count, bufferlimit);
+    i = done < count ? done : count - 1;
+    phases[0] += (unsigned char)(i * frequency1);
+    phases[1] += (unsigned char)(i * frequency2);
+    phases[2] += (unsigned char)(i * frequency3);
+    return done;
 }
 
 // PROCESS THE FRAMES
@@ -42,39 +72,85 @@ static void CombineGlottalAndFormants(unsigned char phase1, unsigned char phase2
 // To simulate them being driven by the glottal pulse, the waveforms are
 // reset at the beginning of each glottal pulse.
 //
-void ProcessFrames(unsigned char mem48)
+// The loop state lives in ctx->frameState so rendering can stop once
+// bufferlimit is reached and resume later with the next call.
+void ProcessFramesInit(SamContext *ctx, unsigned char mem48)
 {
-    unsigned char speedcounter = 72;
-	unsigned char phase1 = 0;
-    unsigned char phase2 = 0;
-	unsigned char phase3 = 0;
-    unsigned char mem66 = 0; //!! was not initialized
-    
-    unsigned char Y = 0;
+    ProcessFramesState *state = &ctx->frameState;
+
+    state->mem48 = mem48;
+    state->speedcounter = 72;
+    state->phase1 = 0;
+    state->phase2 = 0;
+    state->phase3 = 0;
+    state->mem66 = 0; //!! was not initialized
+    state->Y = 0;
+    state->glottal_pulse = ctx->pitches[0];
+    state->mem38 = state->glottal_pulse - (state->glottal_pulse >> 2); // mem44 * 0.75
+}
 
-    unsigned char glottal_pulse = pitches[0];
-    unsigned char mem38 = glottal_pulse - (glottal_pulse >> 2); // mem44 * 0.75
+// Returns 1 if frames are left after bufferpos reached bufferlimit,
+// 0 once all frames have been rendered.
+int ProcessFramesUntil(SamContext *ctx, int bufferlimit)
+{
+    ProcessFramesState *state = &ctx->frameState;
+
+    unsigned char mem48 = state->mem48;
+    unsigned char speedcounter = state->speedcounter;
+    unsigned char phases[3];
+    unsigned char mem66 = state->mem66;
+    unsigned char Y = state->Y;
+    unsigned char glottal_pulse = state->glottal_pulse;
+    unsigned char mem38 = state->mem38;
+
+    phases[0] = state->phase1;
+    phases[1] = state->phase2;
+    phases[2] = state->phase3;
 
 	while(mem48) {
-		unsigned char flags = sampledConsonantFlag[Y];
+		unsigned char flags;
+
+		if (ctx->bufferpos >= bufferlimit) break;
+
+		flags = ctx->sampledConsonantFlag[Y];
 		
 		// unvoiced sampled phoneme?
         if(flags & 248) {
-			RenderSample(&mem66, flags,Y);
+			RenderSample(ctx, &mem66, flags,Y);
 			// skip ahead two in the phoneme buffer
 			Y += 2;
 			mem48 -= 2;
-            speedcounter = speed;
+            speedcounter = ctx->speed;
+            if (SamCancelled(ctx)) break;
 		} else {
-            CombineGlottalAndFormants(phase1, phase2, phase3, Y);
+            // Every tick outputs the formants. Only the tick that ends the
+            // frame, the glottal pulse or, with a voiced sample (flags not
+            // 0), the first 75% of the pulse needs the state updates below,
+            // so the ticks before it are rendered as one run.
+            int run = (speedcounter - 1) & 255;
+            int done;
+            if (((glottal_pulse - 1) & 255) < run) run = (glottal_pulse - 1) & 255;
+            if (flags != 0 && ((mem38 - 1) & 255) < run) run = (mem38 - 1) & 255;
+
+            done = RenderFormantRun(ctx, Y, phases, run, bufferlimit);
+            if (done <= run) { // reached bufferlimit
+                speedcounter -= done;
+                glottal_pulse -= done;
+                mem38 -= done;
+                continue;
+            }
+            speedcounter -= run;
+            glottal_pulse -= run;
+            mem38 -= run;
 
 			speedcounter--;
 			if (speedcounter == 0) { 
                 Y++; //go to next amplitude
                 // decrement the frame count
                 mem48--;
-                if(mem48 == 0) return;
-                speedcounter = speed;
+                if(mem48 == 0) break;
+                speedcounter = ctx->speed;
+                if (SamCancelled(ctx)) break;
             }
          
             --glottal_pulse;
@@ -87,26 +163,38 @@ void ProcessFrames(unsigned char mem48)
                 // is the count non-zero and the sampled flag is zero?
                 if((mem38 != 0) || (flags == 0)) {
                     // reset the phase of the formants to match the pulse
-                    phase1 += frequency1[Y];
-                    phase2 += frequency2[Y];
-                    phase3 += frequency3[Y];
+                    phases[0] += ctx->frequency1[Y];
+                    phases[1] += ctx->frequency2[Y];
+                    phases[2] += ctx->frequency3[Y];
                     continue;
                 }
                 
                 // voiced sampled phonemes interleave the sample with the
                 // glottal pulse. The sample flag is non-zero, so render
                 // the sample for the phoneme.
-                RenderSample(&mem66, flags,Y);
+                RenderSample(ctx, &mem66, flags,Y);
             }
         }
 
-        glottal_pulse = pitches[Y];
+        glottal_pulse = ctx->pitches[Y];
         mem38 = glottal_pulse - (glottal_pulse>>2); // mem44 * 0.75
 
         // reset the formant wave generators to keep them in 
         // sync with the glottal pulse
-        phase1 = 0;
-        phase2 = 0;
-        phase3 = 0;
+        phases[0] = 0;
+        phases[1] = 0;
+        phases[2] = 0;
 	}
+
+    state->mem48 = mem48;
+    state->speedcounter = speedcounter;
+    state->phase1 = phases[0];
+    state->phase2 = phases[1];
+    state->phase3 = phases[2];
+    state->mem66 = mem66;
+    state->Y = Y;
+    state->glottal_pulse = glottal_pulse;
+    state->mem38 = mem38;
+
+    return mem48 != 0;
 }
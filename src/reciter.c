@@ -1,26 +1,26 @@
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include "reciter.h"
+#include "samcontext.h"
 #include "ReciterTabs.h"
+#include "ReciterRuleTabs.h"
 #include "debug.h"
 
-unsigned char A, X;
 extern int debug;
 
-static unsigned char inputtemp[256];   // secure copy of input tab36096
-
 /* Retrieve flags for character at mem59-1 */
-unsigned char Code37055(unsigned char npos, unsigned char mask)
+unsigned char Code37055(SamContext *ctx, unsigned char npos, unsigned char mask)
 {
-	X = npos;
-	return tab36376[inputtemp[X]] & mask;
+	ctx->X = npos;
+	return tab36376[ctx->inputtemp[ctx->X]] & mask;
 }
 
-unsigned int match(const char * str) {
+unsigned int match(SamContext *ctx, const char * str) {
     while (*str) {
         unsigned char ch = *str;
-        A = inputtemp[X++];
-        if (A != ch) return 0;
+        ctx->A = ctx->inputtemp[ctx->X++];
+        if (ctx->A != ch) return 0;
         ++str;
     }
     return 1;
@@ -36,10 +36,10 @@ unsigned char GetRuleByte(unsigned short mem62, unsigned char Y) {
 	return rules[address+Y];
 }
 
-int handle_ch2(unsigned char ch, unsigned char mem) {
+int handle_ch2(SamContext *ctx, unsigned char ch, unsigned char mem) {
     unsigned char tmp;
-    X = mem;
-    tmp = tab36376[inputtemp[mem]];
+    ctx->X = mem;
+    tmp = tab36376[ctx->inputtemp[mem]];
     if (ch == ' ') {
         if(tmp & 128) return 1;
     } else if (ch == '#') {
@@ -53,10 +53,10 @@ int handle_ch2(unsigned char ch, unsigned char mem) {
 }
 
 
-int handle_ch(unsigned char ch, unsigned char mem) {
+int handle_ch(SamContext *ctx, unsigned char ch, unsigned char mem) {
     unsigned char tmp;
-    X = mem;
-    tmp = tab36376[inputtemp[X]];
+    ctx->X = mem;
+    tmp = tab36376[ctx->inputtemp[ctx->X]];
     if (ch == ' ') {
         if ((tmp & 128) != 0) return 1;
     } else if (ch == '#') {
@@ -65,28 +65,32 @@ int handle_ch(unsigned char ch, unsigned char mem) {
         if((tmp & 8) == 0) return 1;
     } else if (ch == '&') {
         if((tmp & 16) == 0) {
-            if (inputtemp[X] != 72) return 1;
-            ++X;
+            if (ctx->inputtemp[ctx->X] != 72) return 1;
+            ++ctx->X;
         }
     } else if (ch == '^') {
         if ((tmp & 32) == 0) return 1;
     } else if (ch == '+') {
-        X = mem;
-        ch = inputtemp[X];
+        ctx->X = mem;
+        ch = ctx->inputtemp[ctx->X];
         if ((ch != 69) && (ch != 73) && (ch != 89)) return 1;
     } else return -1;
     return 0;
 }
 
 
-int TextToPhonemes(unsigned char *input) {
+// Converts input in place, ending at the first '[' or, if stop is below
+// 256, at inputtemp[stop], which holds input[stop-1].
+static int Recite(SamContext *ctx, unsigned char *input, int stop) {
 	unsigned char mem56;      //output position for phonemes
 	unsigned char mem57;
 	unsigned char mem58;
 	unsigned char mem59;
 	unsigned char mem60;
 	unsigned char mem61;
-	unsigned short mem62;     // memory position of current rule
+	const ReciterRule *rule;  // current rule
+	const unsigned char *rb;  // bytes of the current rule
+	int ruleIndex, ruleEnd;   // candidates left for this character
 
 	unsigned char mem64;      // position of '=' or current character
 	unsigned char mem65;     // position of ')'
@@ -96,82 +100,85 @@ int TextToPhonemes(unsigned char *input) {
 
 	int r;
 
-	inputtemp[0] = ' ';
+	ctx->cancelled = 0;
+	ctx->inputtemp[0] = ' ';
 
 	// secure copy of input
 	// because input will be overwritten by phonemes
-	X = 0;
+	ctx->X = 0;
 	do {
-		A = input[X] & 127;
-		if ( A >= 112) A = A & 95;
-		else if ( A >= 96) A = A & 79;
-		inputtemp[++X] = A;
-	} while (X < 255);
-	inputtemp[255] = 27;
+		ctx->A = input[ctx->X] & 127;
+		if ( ctx->A >= 112) ctx->A = ctx->A & 95;
+		else if ( ctx->A >= 96) ctx->A = ctx->A & 79;
+		ctx->inputtemp[++ctx->X] = ctx->A;
+	} while (ctx->X < 255);
+	ctx->inputtemp[255] = 27;
 	mem56 = mem61 = 255;
 
 pos36554:
     while (1) {
         while(1) {
-            X = ++mem61;
-            mem64 = inputtemp[X];
-            if (mem64 == '[') {
-                X = ++mem56;
-                input[X] = 155;
+            ctx->X = ++mem61;
+            mem64 = ctx->inputtemp[ctx->X];
+            if (mem64 == '[' || ctx->X == stop) {
+                ctx->X = ++mem56;
+                input[ctx->X] = 155;
                 return 1;
             }
             
             if (mem64 != '.') break;
-            X++;
-            A = tab36376[inputtemp[X]] & 1;
-            if(A != 0) break;
+            ctx->X++;
+            ctx->A = tab36376[ctx->inputtemp[ctx->X]] & 1;
+            if(ctx->A != 0) break;
             mem56++;
-            X = mem56;
-            A = '.';
-            input[X] = '.';
+            ctx->X = mem56;
+            ctx->A = '.';
+            input[ctx->X] = '.';
         }
         mem57 = tab36376[mem64];
         if((mem57&2) != 0) {
-            mem62 = 37541;
+            ruleIndex = reciterSectionStart[26] - 1;
+            ruleEnd = reciterSectionEnd[26];
             goto pos36700;
         }
         
         if(mem57 != 0) break;
-        inputtemp[X] = ' ';
-        X = ++mem56;
-        if (X > 120) {
-            input[X] = 155;
+        // end of a word
+        if (SamCancelled(ctx)) return 0;
+        ctx->inputtemp[ctx->X] = ' ';
+        ctx->X = ++mem56;
+        if (ctx->X > 120) {
+            input[ctx->X] = 155;
             return 1;
         }
-        input[X] = 32;
+        input[ctx->X] = 32;
     }
 
     if(!(mem57 & 128)) return 0;
 
 	// go to the right rules for this character.
-    X = mem64 - 'A';
-    mem62 = tab37489[X] | (tab37515[X]<<8);
+    ctx->X = mem64 - 'A';
+    ruleIndex = reciterSectionStart[ctx->X] - 1;
+    ruleEnd = reciterSectionEnd[ctx->X];
 
 pos36700:
-	// find next rule
-	while ((GetRuleByte(++mem62, 0) & 128) == 0);
-	Y = 0;
-	while(GetRuleByte(mem62, ++Y) != '(');
-	mem66 = Y;
-    while(GetRuleByte(mem62, ++Y) != ')');
-	mem65 = Y;
-	while((GetRuleByte(mem62, ++Y) & 127) != '=');
-	mem64 = Y;
+	// next candidate rule
+	if (++ruleIndex >= ruleEnd) return 0;
+	rule = &reciterRules[ruleIndex];
+	rb = rule->bytes;
+	mem66 = rule->open;
+	mem65 = rule->close;
+	mem64 = rule->equals;
 
 	
-	mem60 = X = mem61;
+	mem60 = ctx->X = mem61;
 	// compare the string within the bracket
 	Y = mem66 + 1;
 
 	while(1) {
-		if (GetRuleByte(mem62, Y) != inputtemp[X]) goto pos36700;
+		if (rb[Y] != ctx->inputtemp[ctx->X]) goto pos36700;
 		if(++Y == mem65) break;
-		mem60 = ++X;
+		mem60 = ++ctx->X;
 	}
 
     // the string in the bracket is correct
@@ -182,46 +189,46 @@ pos36700:
 		unsigned char ch;
 		while(1) {
             mem66--;
-            mem57 = GetRuleByte(mem62, mem66);
+            mem57 = rb[mem66];
             if ((mem57 & 128) != 0) {
                 mem58 = mem60;
                 goto pos37184;
             }
-            X = mem57 & 127;
-            if ((tab36376[X] & 128) == 0) break;
-            if (inputtemp[mem59-1] != mem57) goto pos36700;
+            ctx->X = mem57 & 127;
+            if ((tab36376[ctx->X] & 128) == 0) break;
+            if (ctx->inputtemp[mem59-1] != mem57) goto pos36700;
             --mem59;
         }
 
         ch = mem57;
 
-        r = handle_ch2(ch, mem59-1);
+        r = handle_ch2(ctx, ch, mem59-1);
         if (r == -1) {
             switch (ch) {
             case '&':
-                if (!Code37055(mem59-1,16)) {
-                    if (inputtemp[X] != 'H') r = 1;
+                if (!Code37055(ctx, mem59-1,16)) {
+                    if (ctx->inputtemp[ctx->X] != 'H') r = 1;
                     else {
-                        A = inputtemp[--X];
-                        if ((A != 'C') && (A != 'S')) r = 1;
+                        ctx->A = ctx->inputtemp[--ctx->X];
+                        if ((ctx->A != 'C') && (ctx->A != 'S')) r = 1;
                     }
                 }
                 break;
                 
             case '@':
-                if(!Code37055(mem59-1,4)) { 
-                    A = inputtemp[X];
-                    if (A != 72) r = 1;
-                    if ((A != 84) && (A != 67) && (A != 83)) r = 1;
+                if(!Code37055(ctx, mem59-1,4)) { 
+                    ctx->A = ctx->inputtemp[ctx->X];
+                    if (ctx->A != 72) r = 1;
+                    if ((ctx->A != 84) && (ctx->A != 67) && (ctx->A != 83)) r = 1;
                 }
                 break;
             case '+':
-                X = mem59;
-                A = inputtemp[--X];
-                if ((A != 'E') && (A != 'I') && (A != 'Y')) r = 1;
+                ctx->X = mem59;
+                ctx->A = ctx->inputtemp[--ctx->X];
+                if ((ctx->A != 'E') && (ctx->A != 'I') && (ctx->A != 'Y')) r = 1;
                 break;
             case ':':
-                while (Code37055(mem59-1,32)) --mem59;
+                while (Code37055(ctx, mem59-1,32)) --mem59;
                 continue;
             default:
                 return 0;
@@ -230,21 +237,21 @@ pos36700:
 
         if (r == 1) goto pos36700;
 
-        mem59 = X;
+        mem59 = ctx->X;
     }
 
     do {
-        X = mem58+1;
-        if (inputtemp[X] == 'E') {
-            if((tab36376[inputtemp[X+1]] & 128) != 0) {
-                A = inputtemp[++X];
-                if (A == 'L') {
-                    if (inputtemp[++X] != 'Y') goto pos36700;
-                } else if ((A != 'R') && (A != 'S') && (A != 'D') && !match("FUL")) goto pos36700;
+        ctx->X = mem58+1;
+        if (ctx->inputtemp[ctx->X] == 'E') {
+            if((tab36376[ctx->inputtemp[ctx->X+1]] & 128) != 0) {
+                ctx->A = ctx->inputtemp[++ctx->X];
+                if (ctx->A == 'L') {
+                    if (ctx->inputtemp[++ctx->X] != 'Y') goto pos36700;
+                } else if ((ctx->A != 'R') && (ctx->A != 'S') && (ctx->A != 'D') && !match(ctx, "FUL")) goto pos36700;
             }
         } else {
-            if (!match("ING")) goto pos36700;
-            mem58 = X;
+            if (!match(ctx, "ING")) goto pos36700;
+            mem58 = ctx->X;
         }
         
 pos37184:
@@ -255,20 +262,20 @@ pos37184:
                 if(Y == mem64) {
                     mem61 = mem60;
                     
-                    if (debug) PrintRule(mem62);
+                    if (debug) PrintRule(rule->address);
                     
                     while(1) {
-                        mem57 = A = GetRuleByte(mem62, Y);
-                        A = A & 127;
-                        if (A != '=') input[++mem56] = A;
+                        mem57 = ctx->A = rb[Y];
+                        ctx->A = ctx->A & 127;
+                        if (ctx->A != '=') input[++mem56] = ctx->A;
                         if ((mem57 & 128) != 0) goto pos36554;
                         Y++;
                     }
                 }
                 mem65 = Y;
-                mem57 = GetRuleByte(mem62, Y);
+                mem57 = rb[Y];
                 if((tab36376[mem57] & 128) == 0) break;
-                if (inputtemp[mem58+1] != mem57) {
+                if (ctx->inputtemp[mem58+1] != mem57) {
                     r = 1;
                     break;
                 }
@@ -276,19 +283,19 @@ pos37184:
             }
 
             if (r == 0) {
-                A = mem57;
-                if (A == '@') {
-                    if(Code37055(mem58+1, 4) == 0) {
-                        A = inputtemp[X];
-                        if ((A != 82) && (A != 84) && 
-                            (A != 67) && (A != 83)) r = 1;
+                ctx->A = mem57;
+                if (ctx->A == '@') {
+                    if(Code37055(ctx, mem58+1, 4) == 0) {
+                        ctx->A = ctx->inputtemp[ctx->X];
+                        if ((ctx->A != 82) && (ctx->A != 84) && 
+                            (ctx->A != 67) && (ctx->A != 83)) r = 1;
                     } else {
                         r = -2;
                     }
-                } else if (A == ':') {
-                    while (Code37055(mem58+1, 32)) mem58 = X;
+                } else if (ctx->A == ':') {
+                    while (Code37055(ctx, mem58+1, 32)) mem58 = ctx->X;
                     r = -2;
-                } else r = handle_ch(A, mem58+1);
+                } else r = handle_ch(ctx, ctx->A, mem58+1);
             }
 
             if (r == 1) goto pos36700;
@@ -296,8 +303,116 @@ pos37184:
                 r = 0;
                 continue;
             }
-            if (r == 0) mem58 = X;
+            if (r == 0) mem58 = ctx->X;
         } while (r == 0);
-    } while (A == '%');
+    } while (ctx->A == '%');
 	return 0;
 }
+
+int SamTextToPhonemes(SamContext *ctx, unsigned char *input) {
+	return Recite(ctx, input, 256);
+}
+
+// Longest word SamWordToPhonemes accepts. No character expands to more
+// than 15 bytes, so the phonemes of such a word always fit in the 256
+// byte buffer.
+static const int kReciterMaxWord = 15;
+
+int SamWordToPhonemes(SamContext *ctx, const char *word, int length, int beforeVowel, unsigned char *output)
+{
+	unsigned char buffer[256];
+	int n = length;
+	int k;
+
+	if (length < 1 || length > kReciterMaxWord) return 0;
+
+	// any vowel stands in for the next word
+	memcpy(buffer, word, length);
+	if (beforeVowel) {
+		buffer[n++] = ' ';
+		buffer[n++] = 'A';
+	}
+	buffer[n++] = '[';
+	buffer[n] = 0;
+
+	// stop on the character after the word
+	if (!Recite(ctx, buffer, length + 1)) return 0;
+
+	// skip the pause for the space in front of the text
+	for (k = 1; buffer[k] != 155; k++) output[k-1] = buffer[k];
+	output[k-1] = 0;
+	return 1;
+}
+
+// SamTextToPhonemes works in place on a 256 byte buffer and stops at the
+// first word boundary after kReciterMaxPhonemes bytes of output, so longer
+// text is recited in pieces that end after a space.
+static const int kReciterMaxText = 254;
+static const int kReciterMaxPhonemes = 120;
+
+// Length of the longest prefix of text, at most limit bytes, that ends
+// with a space. Returns 0 if there is none.
+static int WordPrefix(const char *text, int limit)
+{
+	while (limit > 0 && text[limit-1] != ' ') limit--;
+	return limit;
+}
+
+int SamSetText(SamContext *ctx, const char *text)
+{
+	unsigned char piece[256];
+	unsigned char *phonemes = NULL;
+	int length = 0;
+	int size = 0;
+	int pos = 0;
+	int total = strlen(text);
+
+	do {
+		int n = total - pos;
+		int k, cut;
+
+		if (n > kReciterMaxText) {
+			cut = WordPrefix(text + pos, kReciterMaxText);
+			n = cut ? cut : kReciterMaxText;
+		}
+
+		while (1) {
+			memcpy(piece, text + pos, n);
+			piece[n] = '[';
+			piece[n+1] = 0;
+			if (!SamTextToPhonemes(ctx, piece)) {
+				free(phonemes);
+				return 0;
+			}
+			for (k = 0; piece[k] != 155; k++);
+			if (k <= kReciterMaxPhonemes) break;
+
+			// possibly cut short, try again with fewer words
+			cut = WordPrefix(text + pos, n / 2);
+			if (cut == 0) break;
+			n = cut;
+		}
+
+		// room for the piece and the terminator
+		if (length + k + 1 > size) {
+			unsigned char *grown;
+			size = 2 * size + 256;
+			grown = realloc(phonemes, size);
+			if (grown == NULL) {
+				free(phonemes);
+				return 0;
+			}
+			phonemes = grown;
+		}
+		memcpy(phonemes + length, piece, k);
+		length += k;
+		pos += n;
+	} while (pos < total);
+
+	phonemes[length] = 0;
+	SamSetInput(ctx, phonemes);
+	free(phonemes);
+	return 1;
+}
+
+int TextToPhonemes(unsigned char *input) {return SamTextToPhonemes(SamDefaultContext(), input);}
@@ -3,6 +3,24 @@
 
 //int TextToPhonemes(unsigned char *input, unsigned char *output);
 
+#include "sam.h"
+
+int SamTextToPhonemes(SamContext *ctx, unsigned char *input);
+
+// Converts one word of at most 15 characters, without spaces, to phonemes.
+// The only rule that looks past the end of a word, " (THE) #", checks
+// whether the next word starts with a vowel, so that is all the context
+// needed: a text converts to a pause followed by the phonemes of its
+// words, with a pause for every space. output needs 256 bytes and is 0
+// terminated. Returns 0 if the word is too long or contains characters
+// the reciter does not know.
+int SamWordToPhonemes(SamContext *ctx, const char *word, int length, int beforeVowel, unsigned char *output);
+
+// Converts text of any length to phonemes and passes them to SamSetInput.
+// Returns 0 if the text contains characters the reciter does not know.
+int SamSetText(SamContext *ctx, const char *text);
+
+// Converts using the default context, see SetInput() and SAMMain().
 int TextToPhonemes(unsigned char *input);
 
 #endif
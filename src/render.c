@@ -1,53 +1,19 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include "render.h"
+#include "samcontext.h"
 #include "RenderTabs.h"
 
 #include "debug.h"
 extern int debug;
 
-//extern unsigned char A, X, Y;
-//extern unsigned char mem44;
+void AddInflection(SamContext *ctx, unsigned char mem48, unsigned char X);
 
-extern unsigned char speed;
-extern unsigned char pitch;
-extern int singmode;
 
 
-extern unsigned char phonemeIndexOutput[60]; //tab47296
-extern unsigned char stressOutput[60]; //tab47365
-extern unsigned char phonemeLengthOutput[60]; //tab47416
-
-unsigned char pitches[256]; // tab43008
-
-unsigned char frequency1[256];
-unsigned char frequency2[256];
-unsigned char frequency3[256];
-
-unsigned char amplitude1[256];
-unsigned char amplitude2[256];
-unsigned char amplitude3[256];
-
-unsigned char sampledConsonantFlag[256]; // tab44800
-
-
-void AddInflection(unsigned char mem48, unsigned char X);
-
-//return = hibyte(mem39212*mem39213) <<  1
-unsigned char trans(unsigned char a, unsigned char b)
-{
-    return (((unsigned int)a * b) >> 8) << 1;
-}
-
-
-
-
-// contains the final soundbuffer
-extern int bufferpos;
-extern char *buffer;
-
 
 
 //timetable for more accurate c64 simulation
@@ -60,44 +26,186 @@ static const int timetable[5][5] =
 	{199, 0, 0, 54, 54}
 };
 
-void Output(int index, unsigned char A)
+// bufferpos counts C64 cycles, one output sample covers 50 cycles.
+//
+// The original wrote each value to the five samples starting at
+// bufferpos/50 and let the next call overwrite them. Since bufferpos never
+// advances by more than five samples per call, every sample below
+// bufferpos/50 ends up holding the value of the call before, so that is
+// written directly, once per sample.
+void Output(SamContext *ctx, int index, unsigned char A)
 {
-	static unsigned oldtimetableindex = 0;
-	int k;
-	bufferpos += timetable[oldtimetableindex][index];
-	oldtimetableindex = index;
-	// write a little bit in advance
-	for(k=0; k<5; k++)
-		buffer[bufferpos/50 + k] = (A & 15)*16;
+	int pos, end;
+	char *buffer, sample;
+	ctx->bufferpos += timetable[ctx->oldtimetableindex][index];
+	ctx->oldtimetableindex = index;
+
+	end = ctx->bufferpos / 50;
+	if (end > ctx->buffersize && !SamReserveBuffer(ctx, end)) return;
+
+	// locals, so the stores to buffer cannot alias the context fields
+	buffer = ctx->buffer;
+	sample = ctx->lastsample;
+	for (pos = ctx->outpos; pos < end; pos++)
+		buffer[pos] = sample;
+	if (end > ctx->outpos) ctx->outpos = end;
+	ctx->lastsample = (A & 15)*16;
 }
 
+// Same as calling Output(ctx, 0, values[i]) for each value, stopping
+// early once bufferpos reaches bufferlimit. Returns how many values were
+// output.
+int OutputRun(SamContext *ctx, const unsigned char *values, int count, int bufferlimit)
+{
+	int i = 0, pos, end, bufferpos, outpos, phase;
+	char *buffer, sample;
+
+	// an index 0 step is at most 226 cycles, the first one, then 162,
+	// plus room for the spare writes below
+	end = (ctx->bufferpos + 226 + 162 * count) / 50 + 4;
+	if (end > ctx->buffersize && !SamReserveBuffer(ctx, end)) {
+		for (i = 0; i < count && ctx->bufferpos < bufferlimit; i++)
+			Output(ctx, 0, values[i]);
+		return i;
+	}
 
-static unsigned char RenderVoicedSample(unsigned short hi, unsigned char off, unsigned char phase1)
+	buffer = ctx->buffer;
+	sample = ctx->lastsample;
+	bufferpos = ctx->bufferpos;
+	outpos = ctx->outpos;
+
+	// the first step follows whatever was output before
+	if (count > 0 && bufferpos < bufferlimit) {
+		bufferpos += timetable[ctx->oldtimetableindex][0];
+		ctx->oldtimetableindex = 0;
+		end = bufferpos / 50;
+		for (pos = outpos; pos < end; pos++)
+			buffer[pos] = sample;
+		if (end > outpos) outpos = end;
+		sample = (values[i++] & 15)*16;
+	}
+
+	// Every later step is 162 cycles and completes three or four samples.
+	// Four are written and outpos moves past three or four of them; a
+	// spare write is overwritten next or lies past outpos, which is not
+	// final yet.
+	phase = bufferpos - outpos * 50;
+	for (; i < count && bufferpos < bufferlimit; i++) {
+		int n;
+		buffer[outpos] = sample;
+		buffer[outpos + 1] = sample;
+		buffer[outpos + 2] = sample;
+		buffer[outpos + 3] = sample;
+		phase += 162;
+		n = phase >= 200 ? 4 : 3;
+		outpos += n;
+		phase -= n * 50;
+		bufferpos += 162;
+		sample = (values[i] & 15)*16;
+	}
+	ctx->bufferpos = bufferpos;
+	ctx->outpos = outpos;
+	ctx->lastsample = sample;
+	return i;
+}
+
+
+// Outputs the bits of count bytes of a 256 byte sample bank, starting at
+// off and wrapping around, high bit first. A set bit is Output(ctx,
+// oneIndex, one), a clear bit Output(ctx, zeroIndex, zero). The steps
+// between the two indices are looked up once and the buffer is reserved
+// for the whole run, instead of once per bit.
+static void OutputSampleBits(SamContext *ctx, const unsigned char *bank, unsigned char off, int count,
+                             int oneIndex, unsigned char one, int zeroIndex, unsigned char zero)
+{
+	int steps[2][2]; // [previous bit][bit]
+	int i, bit, pos, end, bufferpos, outpos, step, maxstep, phase;
+	char *buffer, sample;
+
+	steps[0][0] = timetable[zeroIndex][zeroIndex];
+	steps[0][1] = timetable[zeroIndex][oneIndex];
+	steps[1][0] = timetable[oneIndex][zeroIndex];
+	steps[1][1] = timetable[oneIndex][oneIndex];
+	maxstep = steps[0][0];
+	for (i = 1; i < 4; i++)
+		if (steps[i>>1][i&1] > maxstep) maxstep = steps[i>>1][i&1];
+
+	// one more for the spare write below
+	end = (ctx->bufferpos + 226 + maxstep * 8 * count) / 50 + 1;
+	if (end > ctx->buffersize && !SamReserveBuffer(ctx, end)) {
+		for (i = 0; i < count; i++, off++)
+			for (bit = 7; bit >= 0; bit--) {
+				if ((bank[off] >> bit) & 1) Output(ctx, oneIndex, one);
+				else Output(ctx, zeroIndex, zero);
+			}
+		return;
+	}
+
+	one = (one & 15)*16;
+	zero = (zero & 15)*16;
+	buffer = ctx->buffer;
+	sample = ctx->lastsample;
+	bufferpos = ctx->bufferpos;
+	outpos = ctx->outpos;
+
+	// The first step follows whatever was output before and may be long.
+	bit = bank[off] >> 7;
+	bufferpos += timetable[ctx->oldtimetableindex][bit ? oneIndex : zeroIndex];
+	end = bufferpos / 50;
+	for (pos = outpos; pos < end; pos++)
+		buffer[pos] = sample;
+	if (end > outpos) outpos = end;
+	sample = bit ? one : zero;
+
+	// The sampled steps are 54 to 60 cycles, so every later bit completes
+	// one or two samples. Writing two and keeping one or both avoids the
+	// division and the fill loop; a spare write is overwritten by the next
+	// bit or lies past outpos, which is not final yet.
+	phase = bufferpos - outpos * 50;
+	for (i = 0; i < count; i++, off++) {
+		unsigned char bits = bank[off];
+		int n = 0;
+		if (i == 0) {
+			bits <<= 1;
+			n = 1;
+		}
+		for (; n < 8; n++) {
+			int next = bits >> 7;
+			step = steps[bit][next];
+			bit = next;
+			bits <<= 1;
+
+			buffer[outpos] = sample;
+			buffer[outpos + 1] = sample;
+			phase += step;
+			if (phase >= 100) {
+				outpos += 2;
+				phase -= 100;
+			} else if (phase >= 50) {
+				outpos += 1;
+				phase -= 50;
+			}
+			bufferpos += step;
+			sample = bit ? one : zero;
+		}
+	}
+	ctx->oldtimetableindex = bit ? oneIndex : zeroIndex;
+	ctx->bufferpos = bufferpos;
+	ctx->outpos = outpos;
+	ctx->lastsample = sample;
+}
+
+static unsigned char RenderVoicedSample(SamContext *ctx, unsigned short hi, unsigned char off, unsigned char phase1)
 {
-	do {
-		unsigned char bit = 8;
-		unsigned char sample = sampleTable[hi+off];
-		do {
-			if ((sample & 128) != 0) Output(3, 26);
-			else Output(4, 6);
-			sample <<= 1;
-		} while(--bit != 0);
-		off++;
-	} while (++phase1 != 0);
-	return off;
+	// bytes up to phase1 wrapping to 0
+	int count = 256 - phase1;
+	OutputSampleBits(ctx, sampleTable + hi, off, count, 3, 26, 4, 6);
+	return (unsigned char)(off + count);
 }
 
-static void RenderUnvoicedSample(unsigned short hi, unsigned char off, unsigned char mem53)
+static void RenderUnvoicedSample(SamContext *ctx, unsigned short hi, unsigned char off, unsigned char mem53)
 {
-    do {
-        unsigned char bit = 8;
-        unsigned char sample = sampleTable[hi+off];
-        do {
-            if ((sample & 128) != 0) Output(2, 5);
-            else Output(1, mem53);
-            sample <<= 1;
-        } while (--bit != 0);
-    } while (++off != 0);
+	OutputSampleBits(ctx, sampleTable + hi, off, 256 - off, 2, 5, 1, mem53);
 }
 
 
@@ -157,7 +265,7 @@ static void RenderUnvoicedSample(unsigned short hi, unsigned char off, unsigned
 // For voices samples, samples are interleaved between voiced output.
 
 
-void RenderSample(unsigned char *mem66, unsigned char consonantFlag, unsigned char mem49)
+void RenderSample(SamContext *ctx, unsigned char *mem66, unsigned char consonantFlag, unsigned char mem49)
 {     
 	// mem49 == current phoneme's index
 
@@ -177,11 +285,11 @@ void RenderSample(unsigned char *mem66, unsigned char consonantFlag, unsigned ch
 	unsigned char pitchl = consonantFlag & 248;
 	if(pitchl == 0) {
         // voiced phoneme: Z*, ZH, V*, DH
-		pitchl = pitches[mem49] >> 4;
-        *mem66 = RenderVoicedSample(hi, *mem66, pitchl ^ 255);
+		pitchl = ctx->pitches[mem49] >> 4;
+        *mem66 = RenderVoicedSample(ctx, hi, *mem66, pitchl ^ 255);
 	}
 	else
-		RenderUnvoicedSample(hi, pitchl^255, tab48426[hibyte]);
+		RenderUnvoicedSample(ctx, hi, pitchl^255, tab48426[hibyte]);
 }
 
 
@@ -194,43 +302,47 @@ void RenderSample(unsigned char *mem66, unsigned char consonantFlag, unsigned ch
 //
 // The parameters are copied from the phoneme to the frame verbatim.
 //
-static void CreateFrames()
+static void CreateFrames(SamContext *ctx)
 {
 	unsigned char X = 0;
+    int frames = 0;
     unsigned int i = 0;
     while(i < 256) {
         // get the phoneme at the index
-        unsigned char phoneme = phonemeIndexOutput[i];
+        unsigned char phoneme = ctx->phonemeIndexOutput[i];
 		unsigned char phase1;
 		unsigned phase2;
 	
         // if terminal phoneme, exit the loop
         if (phoneme == 255) break;
 	
-        if (phoneme == PHONEME_PERIOD)   AddInflection(RISING_INFLECTION, X);
-        else if (phoneme == PHONEME_QUESTION) AddInflection(FALLING_INFLECTION, X);
+        if (phoneme == PHONEME_PERIOD)   AddInflection(ctx, RISING_INFLECTION, X);
+        else if (phoneme == PHONEME_QUESTION) AddInflection(ctx, FALLING_INFLECTION, X);
 
         // get the stress amount (more stress = higher pitch)
-        phase1 = tab47492[stressOutput[i] + 1];
+        phase1 = tab47492[ctx->stressOutput[i] + 1];
 	
         // get number of frames to write
-        phase2 = phonemeLengthOutput[i];
+        phase2 = ctx->phonemeLengthOutput[i];
 	
         // copy from the source to the frames list
         do {
-            frequency1[X] = freq1data[phoneme];     // F1 frequency
-            frequency2[X] = freq2data[phoneme];     // F2 frequency
-            frequency3[X] = freq3data[phoneme];     // F3 frequency
-            amplitude1[X] = ampl1data[phoneme];     // F1 amplitude
-            amplitude2[X] = ampl2data[phoneme];     // F2 amplitude
-            amplitude3[X] = ampl3data[phoneme];     // F3 amplitude
-            sampledConsonantFlag[X] = sampledConsonantFlags[phoneme];        // phoneme data for sampled consonants
-            pitches[X] = pitch + phase1;      // pitch
+            ctx->frequency1[X] = ctx->freq1data[phoneme];     // F1 frequency
+            ctx->frequency2[X] = ctx->freq2data[phoneme];     // F2 frequency
+            ctx->frequency3[X] = freq3data[phoneme];     // F3 frequency
+            ctx->amplitude1[X] = ampl1data[phoneme];     // F1 amplitude
+            ctx->amplitude2[X] = ampl2data[phoneme];     // F2 amplitude
+            ctx->amplitude3[X] = ampl3data[phoneme];     // F3 amplitude
+            ctx->sampledConsonantFlag[X] = sampledConsonantFlags[phoneme];        // phoneme data for sampled consonants
+            ctx->pitches[X] = ctx->pitch + phase1;      // pitch
             ++X;
+            ++frames;
         } while(--phase2 != 0);
         
         ++i;
     }
+
+    if (frames > ctx->framesUsed) ctx->framesUsed = frames < 256 ? frames : 256;
 }
 
 
@@ -238,14 +350,18 @@ static void CreateFrames()
 //
 // Rescale volume from a linear scale to decibels.
 //
-void RescaleAmplitude() 
+// Like AssignPitchContour this used to run over all 256 frames. Frames
+// that were never written are 0, which neither step changes, so only the
+// frames written so far are visited.
+//
+void RescaleAmplitude(SamContext *ctx) 
 {
     int i;
-    for(i=255; i>=0; i--)
+    for(i=ctx->framesUsed-1; i>=0; i--)
         {
-            amplitude1[i] = amplitudeRescale[amplitude1[i]];
-            amplitude2[i] = amplitudeRescale[amplitude2[i]];
-            amplitude3[i] = amplitudeRescale[amplitude3[i]];
+            ctx->amplitude1[i] = amplitudeRescale[ctx->amplitude1[i]];
+            ctx->amplitude2[i] = amplitudeRescale[ctx->amplitude2[i]];
+            ctx->amplitude3[i] = amplitudeRescale[ctx->amplitude3[i]];
         }
 }
 
@@ -257,13 +373,13 @@ void RescaleAmplitude()
 // pitch contour. Without this, the output would be at a single
 // pitch level (monotone).
 
-void AssignPitchContour()
+void AssignPitchContour(SamContext *ctx)
 {	
     int i;
-    for(i=0; i<256; i++) {
+    for(i=0; i<ctx->framesUsed; i++) {
         // subtract half the frequency of the formant 1.
         // this adds variety to the voice
-        pitches[i] -= (frequency1[i] >> 1);
+        ctx->pitches[i] -= (ctx->frequency1[i] >> 1);
     }
 }
 
@@ -281,23 +397,32 @@ void AssignPitchContour()
 // 3. Offset the pitches by the fundamental frequency.
 //
 // 4. Render the each frame.
-void Render()
+//
+// RenderBegin performs steps 1-3 and readies ProcessFrames, returning 0 if
+// there is nothing to render. Step 4 runs in ProcessFramesUntil.
+int RenderBegin(SamContext *ctx)
 {
     unsigned char t;
 
-	if (phonemeIndexOutput[0] == 255) return; //exit if no data
+	if (ctx->phonemeIndexOutput[0] == 255) return 0; //exit if no data
 
-    CreateFrames();
-    t = CreateTransitions();
+    CreateFrames(ctx);
+    t = CreateTransitions(ctx);
 
-    if (!singmode) AssignPitchContour();
-    RescaleAmplitude();
+    if (!ctx->singmode) AssignPitchContour(ctx);
+    RescaleAmplitude(ctx);
 
     if (debug) {
-        PrintOutput(sampledConsonantFlag, frequency1, frequency2, frequency3, amplitude1, amplitude2, amplitude3, pitches);
+        PrintOutput(ctx->sampledConsonantFlag, ctx->frequency1, ctx->frequency2, ctx->frequency3, ctx->amplitude1, ctx->amplitude2, ctx->amplitude3, ctx->pitches);
     }
 
-    ProcessFrames(t);
+    ProcessFramesInit(ctx, t);
+    return 1;
+}
+
+void Render(SamContext *ctx)
+{
+    if (RenderBegin(ctx)) ProcessFramesUntil(ctx, INT_MAX);
 }
 
 
@@ -305,7 +430,7 @@ void Render()
 // index X. A rising inflection is used for questions, and 
 // a falling inflection is used for statements.
 
-void AddInflection(unsigned char inflection, unsigned char pos)
+void AddInflection(SamContext *ctx, unsigned char inflection, unsigned char pos)
 {
     unsigned char A;
     // store the location of the punctuation
@@ -316,16 +441,16 @@ void AddInflection(unsigned char inflection, unsigned char pos)
 
 	// FIXME: Explain this fix better, it's not obvious
 	// ML : A =, fixes a problem with invalid pitch with '.'
-	while( (A = pitches[pos]) == 127) ++pos;
+	while( (A = ctx->pitches[pos]) == 127) ++pos;
 
     while (pos != end) {
         // add the inflection direction
         A += inflection;
 	
         // set the inflection
-        pitches[pos] = A;
+        ctx->pitches[pos] = A;
 
-        while ((++pos != end) && pitches[pos] == 255);
+        while ((++pos != end) && ctx->pitches[pos] == 255);
     } 
 }
 
@@ -334,56 +459,10 @@ void AddInflection(unsigned char inflection, unsigned char pos)
     mouth formant (F1) and the throat formant (F2). Only the voiced
     phonemes (5-29 and 48-53) are altered.
 */
-void SetMouthThroat(unsigned char mouth, unsigned char throat)
+void SetMouthThroat(SamContext *ctx, unsigned char mouth, unsigned char throat)
 {
-	// mouth formants (F1) 5..29
-	static const unsigned char mouthFormants5_29[30] = {
-		0, 0, 0, 0, 0, 10,
-		14, 19, 24, 27, 23, 21, 16, 20, 14, 18, 14, 18, 18,
-		16, 13, 15, 11, 18, 14, 11, 9, 6, 6, 6};
-
-	// throat formants (F2) 5..29
-	static const unsigned char throatFormants5_29[30] = {
-	255, 255,
-	255, 255, 255, 84, 73, 67, 63, 40, 44, 31, 37, 45, 73, 49,
-	36, 30, 51, 37, 29, 69, 24, 50, 30, 24, 83, 46, 54, 86,
-    };
-
-	// there must be no zeros in this 2 tables
-	// formant 1 frequencies (mouth) 48..53
-	static const unsigned char mouthFormants48_53[6] = {19, 27, 21, 27, 18, 13};
-       
-	// formant 2 frequencies (throat) 48..53
-	static const unsigned char throatFormants48_53[6] = {72, 39, 31, 43, 30, 34};
-
-	unsigned char newFrequency = 0;
-	unsigned char pos = 5;
-
-	// recalculate formant frequencies 5..29 for the mouth (F1) and throat (F2)
-	while(pos < 30)
-	{
-		// recalculate mouth frequency
-		unsigned char initialFrequency = mouthFormants5_29[pos];
-		if (initialFrequency != 0) newFrequency = trans(mouth, initialFrequency);
-		freq1data[pos] = newFrequency;
-               
-		// recalculate throat frequency
-		initialFrequency = throatFormants5_29[pos];
-		if(initialFrequency != 0) newFrequency = trans(throat, initialFrequency);
-		freq2data[pos] = newFrequency;
-		pos++;
-	}
-
-	// recalculate formant frequencies 48..53
-	pos = 0;
-    while(pos < 6) {
-		// recalculate F1 (mouth formant)
-		unsigned char initialFrequency = mouthFormants48_53[pos];
-		freq1data[pos+48] = trans(mouth, initialFrequency);
-           
-		// recalculate F2 (throat formant)
-		initialFrequency = throatFormants48_53[pos];
-		freq2data[pos+48] = trans(throat, initialFrequency);
-		pos++;
-	}
+	// F1 only depends on the mouth and F2 only on the throat, RenderTabs.h
+	// has both scaled for every setting
+	ctx->freq1data = mouthFreq1[mouth];
+	ctx->freq2data = throatFreq2[throat];
 }
@@ -1,12 +1,18 @@
 #ifndef RENDER_H
 #define RENDER_H
 
-void Render();
-void SetMouthThroat(unsigned char mouth, unsigned char throat);
+#include "sam.h"
 
-void ProcessFrames(unsigned char mem48);
-void RenderSample(unsigned char *mem66, unsigned char consonantFlag, unsigned char mem49);
-unsigned char CreateTransitions();
+void Render(SamContext *ctx);
+int RenderBegin(SamContext *ctx);
+void SetMouthThroat(SamContext *ctx, unsigned char mouth, unsigned char throat);
+
+void Output(SamContext *ctx, int index, unsigned char A);
+int OutputRun(SamContext *ctx, const unsigned char *values, int count, int bufferlimit);
+void ProcessFramesInit(SamContext *ctx, unsigned char mem48);
+int ProcessFramesUntil(SamContext *ctx, int bufferlimit);
+void RenderSample(SamContext *ctx, unsigned char *mem66, unsigned char consonantFlag, unsigned char mem49);
+unsigned char CreateTransitions(SamContext *ctx);
 
 #define PHONEME_PERIOD (1)
 #define PHONEME_QUESTION (2)
@@ -4,8 +4,10 @@
 
 #include "debug.h"
 #include "sam.h"
+#include "samcontext.h"
 #include "render.h"
 #include "SamTabs.h"
+#include "PhonemeNameTabs.h"
 
 enum {
     pR    = 23,
@@ -15,168 +17,499 @@ enum {
     END   = 255
 };
 
-unsigned char input[256]; //tab39445
-//standard sam sound
-unsigned char speed = 72;
-unsigned char pitch = 64;
-unsigned char mouth = 128;
-unsigned char throat = 128;
-int singmode = 0;
-
 extern int debug;
 
-unsigned char stress[256]; //numbers from 0 to 8
-unsigned char phonemeLength[256]; //tab40160
-unsigned char phonemeindex[256];
+// First allocation of an output buffer, about a quarter of a second.
+// Later allocations double it.
+static const int kBufferInitialSize = 4096;
 
-unsigned char phonemeIndexOutput[60]; //tab47296
-unsigned char stressOutput[60]; //tab47365
-unsigned char phonemeLengthOutput[60]; //tab47416
+// Largest number of samples SamStreamRead renders ahead in one step, which
+// keeps a streaming context's buffer at a few kilobytes.
+static const int kStreamChunk = 4096;
 
-// contains the final soundbuffer
-int bufferpos=0;
-char *buffer = NULL;
-static const int kBufferCapacity = 22050 * 10;
+// Phoneme input is parsed in pieces of at most kPieceMax bytes, see
+// ParseNextPiece. The parser inserts phonemes as it goes, so a piece has to
+// stay well below the 256 entries of the phoneme tables. Everything the
+// reciter produces from one buffer fits in a single piece.
+static const int kPieceMax = 160;
 
+static SamContext *defaultContext = NULL;
 
-void SetInput(unsigned char *_input)
+// Output tables of every segment of a parsed input, one segment after the
+// other. Each segment ends in END, which has no length or stress.
+struct SamPhrase
 {
-	int i, l;
-	l = strlen((char*)_input);
-	if (l > 254) l = 254;
-	for(i=0; i<l; i++)
-		input[i] = _input[i];
-	input[l] = 0;
-}
-
-void SetSpeed(unsigned char _speed) {speed = _speed;};
-void SetPitch(unsigned char _pitch) {pitch = _pitch;};
-void SetMouth(unsigned char _mouth) {mouth = _mouth;};
-void SetThroat(unsigned char _throat) {throat = _throat;};
-void EnableSingmode() {singmode = 1;};
-char* GetBuffer(){return buffer;};
-int GetBufferLength(){return bufferpos;};
-
-void Init();
-int Parser1();
-void Parser2();
-int SAMMain();
-void CopyStress();
-void SetPhonemeLength();
-void AdjustLengths();
-void Code41240();
-void Insert(unsigned char position, unsigned char mem60, unsigned char mem59, unsigned char mem58);
-void InsertBreath();
-void PrepareOutput();
-void SetMouthThroat(unsigned char mouth, unsigned char throat);
-
-void Init() {
-	int i;
-	SetMouthThroat( mouth, throat);
+	unsigned char *phonemes;
+	unsigned char *lengths;
+	unsigned char *stresses;
+	int size;
+	int capacity;
+	int segments;
+	int failed; // a piece of the input did not parse
+};
+
+SamContext* SamCreateContext()
+{
+	SamContext *ctx = calloc(1, sizeof(SamContext));
+	if (ctx == NULL) return NULL;
+
+	//standard sam sound
+	ctx->speed = 72;
+	ctx->pitch = 64;
+	ctx->mouth = 128;
+	ctx->throat = 128;
+	return ctx;
+}
+
+void SamDestroyContext(SamContext *ctx)
+{
+	if (ctx == NULL) return;
+	if (ctx->bufferalloc == NULL) free(ctx->buffer);
+	free(ctx->text);
+	free(ctx);
+}
+
+SamContext* SamDefaultContext()
+{
+	if (defaultContext == NULL) defaultContext = SamCreateContext();
+	return defaultContext;
+}
+
+void SamSetInput(SamContext *ctx, unsigned char *_input)
+{
+	int l = 0;
+	while (_input[l] != 0 && _input[l] != 155) l++;
+
+	// room for the end marker
+	if (l + 1 > ctx->textsize) {
+		unsigned char *text = realloc(ctx->text, l + 1);
+		if (text == NULL) {
+			ctx->textlength = 0;
+			return;
+		}
+		ctx->text = text;
+		ctx->textsize = l + 1;
+	}
+	memcpy(ctx->text, _input, l);
+	ctx->text[l] = 155;
+	ctx->textlength = l + 1;
+}
 
-	bufferpos = 0;
-	if (buffer == NULL) {
-		buffer = malloc(kBufferCapacity);
+void SamSetSpeed(SamContext *ctx, unsigned char _speed) {ctx->speed = _speed;};
+void SamSetPitch(SamContext *ctx, unsigned char _pitch) {ctx->pitch = _pitch;};
+void SamSetMouth(SamContext *ctx, unsigned char _mouth) {ctx->mouth = _mouth;};
+void SamSetThroat(SamContext *ctx, unsigned char _throat) {ctx->throat = _throat;};
+void SamEnableSingmode(SamContext *ctx, int _singmode) {ctx->singmode = _singmode;};
+char* SamGetBuffer(SamContext *ctx){return ctx->buffer;};
+int SamGetBufferLength(SamContext *ctx){return ctx->bufferpos;};
+
+void SamSetBufferAlloc(SamContext *ctx, SamBufferAlloc alloc, void *user)
+{
+	if (ctx->bufferalloc == NULL) free(ctx->buffer);
+	ctx->buffer = NULL;
+	ctx->buffersize = 0;
+	ctx->bufferalloc = alloc;
+	ctx->bufferuser = user;
+}
+
+void SamSetCancelCheck(SamContext *ctx, SamCancelCheck cancelled, void *user)
+{
+	ctx->cancelcheck = cancelled;
+	ctx->canceluser = user;
+}
+
+int SamCancelled(SamContext *ctx)
+{
+	if (!ctx->cancelled && ctx->cancelcheck && ctx->cancelcheck(ctx->canceluser))
+		ctx->cancelled = 1;
+	return ctx->cancelled;
+}
+
+int SamReserveBuffer(SamContext *ctx, int size)
+{
+	int newsize;
+	char *newbuffer;
+
+	if (size <= ctx->buffersize) return 1;
+	if (ctx->bufferfailed) return 0;
+
+	newsize = ctx->buffersize ? ctx->buffersize : kBufferInitialSize;
+	while (newsize < size) newsize *= 2;
+
+	if (ctx->bufferalloc)
+		newbuffer = ctx->bufferalloc(ctx->bufferuser, ctx->buffer, newsize);
+	else
+		newbuffer = realloc(ctx->buffer, newsize);
+
+	if (newbuffer == NULL) {
+		ctx->bufferfailed = 1;
+		return 0;
 	}
-	if (buffer != NULL) {
-		memset(buffer, 0, kBufferCapacity);
+	ctx->buffer = newbuffer;
+	ctx->buffersize = newsize;
+	return 1;
+}
+
+void SetInput(unsigned char *_input) {SamSetInput(SamDefaultContext(), _input);};
+void SetSpeed(unsigned char _speed) {SamSetSpeed(SamDefaultContext(), _speed);};
+void SetPitch(unsigned char _pitch) {SamSetPitch(SamDefaultContext(), _pitch);};
+void SetMouth(unsigned char _mouth) {SamSetMouth(SamDefaultContext(), _mouth);};
+void SetThroat(unsigned char _throat) {SamSetThroat(SamDefaultContext(), _throat);};
+void EnableSingmode() {SamEnableSingmode(SamDefaultContext(), 1);};
+int SAMMain() {return SamMain(SamDefaultContext());};
+char* GetBuffer(){return SamGetBuffer(SamDefaultContext());};
+int GetBufferLength(){return SamGetBufferLength(SamDefaultContext());};
+
+void Init(SamContext *ctx);
+int Parser1(SamContext *ctx);
+void Parser2(SamContext *ctx);
+void SetStressAndLength(SamContext *ctx);
+void AdjustLengths(SamContext *ctx);
+void Code41240(SamContext *ctx);
+void Insert(SamContext *ctx, unsigned char position, unsigned char mem60, unsigned char mem59, unsigned char mem58);
+void InsertBreath(SamContext *ctx);
+void PrepareOutput(SamContext *ctx);
+
+// Starts reading the input given to SamSetInput from the beginning.
+static void InitInput(SamContext *ctx) {
+	ctx->textpos = 0;
+	ctx->inputfailed = 0;
+	ctx->outputDone = 1;
+	ctx->segmentActive = 0;
+	ctx->phrase = NULL;
+}
+
+// Prepares the context for rendering the whole input from the start.
+static void InitOutput(SamContext *ctx) {
+	SetMouthThroat(ctx, ctx->mouth, ctx->throat);
+	ctx->oldtimetableindex = 0;
+
+	ctx->bufferpos = 0;
+	ctx->outpos = 0;
+	ctx->lastsample = 0;
+	ctx->bufferfailed = 0;
+	ctx->cancelled = 0;
+	// caller storage is requested afresh for every render
+	if (ctx->bufferalloc) {
+		ctx->buffer = NULL;
+		ctx->buffersize = 0;
 	}
 
+	InitInput(ctx);
+}
+
+// Clears the parser tables before the next piece of input.
+void Init(SamContext *ctx) {
+	int i;
 	for(i=0; i<256; i++) {
-		stress[i] = 0;
-		phonemeLength[i] = 0;
+		ctx->stress[i] = 0;
+		ctx->phonemeLength[i] = 0;
 	}
 
-	for(i=0; i<60; i++) {
-		phonemeIndexOutput[i] = 0;
-		stressOutput[i] = 0;
-		phonemeLengthOutput[i] = 0;
+	for(i=0; i<256; i++) {
+		ctx->phonemeIndexOutput[i] = 0;
+		ctx->stressOutput[i] = 0;
+		ctx->phonemeLengthOutput[i] = 0;
 	}
-	phonemeindex[255] = END; //to prevent buffer overflow // ML : changed from 32 to 255 to stop freezing with long inputs
+	ctx->phonemeindex[255] = END; //to prevent buffer overflow // ML : changed from 32 to 255 to stop freezing with long inputs
 }
 
-int SAMMain() {
-	unsigned char X = 0; //!! is this intended like this?
-	Init();
-	if (buffer == NULL) return 0;
+// Runs the piece of input in input[] through the phoneme rules, leaving
+// the final phoneme, length and stress tables ready for output.
+static int ParsePhonemes(SamContext *ctx) {
+	Init(ctx);
     /* FIXME: At odds with assignment in Init() */
-	phonemeindex[255] = 32; //to prevent buffer overflow
-
-	if (!Parser1()) return 0;
-	if (debug) PrintPhonemes(phonemeindex, phonemeLength, stress);
-	Parser2();
-	CopyStress();
-	SetPhonemeLength();
-	AdjustLengths();
-	Code41240();
-	do {
-		if (phonemeindex[X] > 80) {
-			phonemeindex[X] = END;
-			break; // error: delete all behind it
+	ctx->phonemeindex[255] = 32; //to prevent buffer overflow
+
+	if (!Parser1(ctx)) return 0;
+	if (debug) PrintPhonemes(ctx->phonemeindex, ctx->phonemeLength, ctx->stress);
+	Parser2(ctx);
+	SetStressAndLength(ctx);
+	AdjustLengths(ctx);
+	Code41240(ctx);
+	InsertBreath(ctx);
+
+	if (debug) PrintPhonemes(ctx->phonemeindex, ctx->phonemeLength, ctx->stress);
+
+	ctx->srcpos = 0;
+	ctx->outputDone = 0;
+	return 1;
+}
+
+// Punctuation phonemes. InsertBreath ends a breath group after each.
+static int IsClauseEnd(unsigned char c) {
+	return c == '.' || c == '?' || c == ',' || c == '-';
+}
+
+// Returns 0 if the clause starting at text[pos] ends in punctuation without
+// a vowel before it. AdjustLengths backs up from punctuation to the nearest
+// vowel, which would then lie in the clause before. Every vowel name has
+// one of A, E, I, O or U in it and no other phoneme name does.
+static int ClauseHasVowel(const unsigned char *text, int pos) {
+	for (; text[pos] != 155; pos++) {
+		unsigned char c = text[pos];
+		if (IsClauseEnd(c)) return 0;
+		if (c == 'A' || c == 'E' || c == 'I' || c == 'O' || c == 'U') return 1;
+	}
+	return 1;
+}
+
+// Copies the next piece of text[] into input[] and parses it. Returns 0
+// when the text is used up or the piece could not be parsed.
+//
+// Long input is cut after punctuation that is followed by a space, and the
+// space starts the next piece. InsertBreath starts a new breath group there
+// anyway, and no rule that looks ahead gets past the punctuation, so the
+// pieces give the same output as parsing the input in one go would. Input
+// with no such place in reach is cut at a space instead, and failing that
+// after a stress digit. That space is parsed twice, at the end of one piece
+// and the start of the next, and adds no length. The rules on either side
+// of such a cut do not see the phonemes across it and the breath group
+// restarts, so a few lengths and the odd glottal stop can differ from an
+// uncut parse.
+static int ParseNextPiece(SamContext *ctx) {
+	const unsigned char *src = ctx->text + ctx->textpos;
+	int n = ctx->textlength - ctx->textpos - 1; // without the end marker
+	int max;
+	int lead = 0;
+	int split = 0;
+	int i;
+
+	if (n < 0) return 0;
+
+	// the rules expect a pause at the start
+	if (ctx->textpos > 0 && src[0] != ' ') lead = 1;
+	max = kPieceMax - lead - 1;
+	if (n > max) {
+		for (i = max; i > 1 && !(src[i] == ' ' && IsClauseEnd(src[i-1]) && ClauseHasVowel(src, i)); i--);
+		if (i == 1) {
+			for (i = max; i > 1 && src[i] != ' '; i--);
+			if (i == 1) // no space, end after a stress digit if possible
+				for (i = max; i > 1 && (src[i-1] < '1' || src[i-1] > '8'); i--);
+			split = 1;
 		}
-	} while (++X != 0);
-	InsertBreath();
+		n = i > 1 ? i : max;
+	}
+
+	ctx->input[0] = ' ';
+	memcpy(ctx->input + lead, src, n);
+	ctx->input[lead + n] = ' ';
+	ctx->input[lead + n + split] = 155;
+	ctx->textpos += n;
+	if (ctx->text[ctx->textpos] == 155) ctx->textpos++;
+
+	if (!ParsePhonemes(ctx)) {
+		ctx->inputfailed = 1;
+		return 0;
+	}
+	return 1;
+}
+
+int SamMain(SamContext *ctx) {
+	InitOutput(ctx);
+	if (!ParseNextPiece(ctx)) return 0;
+	PrepareOutput(ctx);
+	return !ctx->bufferfailed && !ctx->inputfailed && !ctx->cancelled;
+}
 
-	if (debug) PrintPhonemes(phonemeindex, phonemeLength, stress);
+// Copies the next segment of the phrase being rendered into the output
+// tables. Returns 0 after the last one.
+static int NextPhraseSegment(SamContext *ctx) {
+	const SamPhrase *phrase = ctx->phrase;
+	int pos = ctx->phrasepos;
+	int n = 0;
 
-	PrepareOutput();
+	if (pos >= phrase->size) return 0;
+	while (phrase->phonemes[pos + n] != END) n++;
+
+	memcpy(ctx->phonemeIndexOutput, phrase->phonemes + pos, n + 1);
+	memcpy(ctx->phonemeLengthOutput, phrase->lengths + pos, n);
+	memcpy(ctx->stressOutput, phrase->stresses + pos, n);
+	ctx->phrasepos = pos + n + 1;
 	return 1;
 }
 
-void PrepareOutput() {
-	unsigned char srcpos  = 0; // Position in source
+// Copies the next BREAK or END terminated run of phonemes into the output
+// tables, parsing the next piece of input when the current one is done.
+// Returns 0 once the END marker of the last piece has been handed out.
+static int PrepareNextSegment(SamContext *ctx) {
 	unsigned char destpos = 0; // Position in output
 
+	if (ctx->phrase) return NextPhraseSegment(ctx);
+
+	while (ctx->outputDone)
+		if (!ParseNextPiece(ctx)) return 0;
+
 	while(1) {
-		unsigned char A = phonemeindex[srcpos];
-        phonemeIndexOutput[destpos] = A;
+		unsigned char A = ctx->phonemeindex[ctx->srcpos];
+        ctx->phonemeIndexOutput[destpos] = A;
         switch(A) {
         case END:
-			Render();
-			return;
+			ctx->outputDone = 1;
+			return 1;
 		case BREAK:
-			phonemeIndexOutput[destpos] = END;
-			Render();
-			destpos = 0;
-            break;
+			ctx->phonemeIndexOutput[destpos] = END;
+			++ctx->srcpos;
+			return 1;
         case 0:
             break;
         default:
-            phonemeLengthOutput[destpos] = phonemeLength[srcpos];
-            stressOutput[destpos]        = stress[srcpos];
+            ctx->phonemeLengthOutput[destpos] = ctx->phonemeLength[ctx->srcpos];
+            ctx->stressOutput[destpos]        = ctx->stress[ctx->srcpos];
             ++destpos;
             break;
         }
-		++srcpos;
+		++ctx->srcpos;
+	}
+}
+
+void PrepareOutput(SamContext *ctx) {
+	while (!ctx->bufferfailed && !ctx->cancelled && PrepareNextSegment(ctx)) Render(ctx);
+}
+
+int SamStreamBegin(SamContext *ctx) {
+	InitOutput(ctx);
+	return ParseNextPiece(ctx);
+}
+
+// Makes room for count more entries in each table of phrase.
+static int ReservePhrase(SamPhrase *phrase, int count) {
+	unsigned char *tables[3];
+	int capacity = phrase->capacity ? phrase->capacity : 256;
+	int i;
+
+	if (phrase->size + count <= phrase->capacity) return 1;
+	while (capacity < phrase->size + count) capacity *= 2;
+
+	tables[0] = phrase->phonemes;
+	tables[1] = phrase->lengths;
+	tables[2] = phrase->stresses;
+	for (i = 0; i < 3; i++) {
+		unsigned char *table = realloc(tables[i], capacity);
+		if (table == NULL) break;
+		tables[i] = table;
+	}
+	phrase->phonemes = tables[0];
+	phrase->lengths = tables[1];
+	phrase->stresses = tables[2];
+	if (i < 3) return 0;
+
+	phrase->capacity = capacity;
+	return 1;
+}
+
+SamPhrase* SamParse(SamContext *ctx) {
+	SamPhrase *phrase = calloc(1, sizeof(SamPhrase));
+	if (phrase == NULL) return NULL;
+
+	InitInput(ctx);
+	while (PrepareNextSegment(ctx)) {
+		int n = 0;
+		while (ctx->phonemeIndexOutput[n] != END) n++;
+
+		if (!ReservePhrase(phrase, n + 1)) {
+			SamDestroyPhrase(phrase);
+			return NULL;
+		}
+		memcpy(phrase->phonemes + phrase->size, ctx->phonemeIndexOutput, n + 1);
+		memcpy(phrase->lengths + phrase->size, ctx->phonemeLengthOutput, n + 1);
+		memcpy(phrase->stresses + phrase->size, ctx->stressOutput, n + 1);
+		phrase->size += n + 1;
+		phrase->segments++;
+	}
+	phrase->failed = ctx->inputfailed;
+	return phrase;
+}
+
+void SamDestroyPhrase(SamPhrase *phrase)
+{
+	if (phrase == NULL) return;
+	free(phrase->phonemes);
+	free(phrase->lengths);
+	free(phrase->stresses);
+	free(phrase);
+}
+
+int SamRenderPhrase(SamContext *ctx, const SamPhrase *phrase) {
+	InitOutput(ctx);
+	if (phrase->segments == 0) return 0;
+	ctx->phrase = phrase;
+	ctx->phrasepos = 0;
+	PrepareOutput(ctx);
+	return !ctx->bufferfailed && !phrase->failed && !ctx->cancelled;
+}
+
+int SamStreamBeginPhrase(SamContext *ctx, const SamPhrase *phrase) {
+	InitOutput(ctx);
+	if (phrase->segments == 0) return 0;
+	ctx->phrase = phrase;
+	ctx->phrasepos = 0;
+	return 1;
+}
+
+// Renders until at least one more sample is final or the phrase ends.
+// Returns 0 when there is nothing left to render.
+static int StreamAdvance(SamContext *ctx, int wanted) {
+	if (wanted > kStreamChunk) wanted = kStreamChunk;
+
+	while (!ctx->segmentActive) {
+		if (!PrepareNextSegment(ctx)) return 0;
+		ctx->segmentActive = RenderBegin(ctx);
 	}
+	ctx->segmentActive = ProcessFramesUntil(ctx, wanted * 50);
+	return 1;
 }
 
+int SamStreamRead(SamContext *ctx, unsigned char *out, int count) {
+	int written = 0;
+
+	while (written < count) {
+		int ready = ctx->outpos;
+		int n;
+
+		if (ready == 0) {
+			if (ctx->bufferfailed || ctx->cancelled || !StreamAdvance(ctx, count - written)) break;
+			continue;
+		}
+
+		n = count - written;
+		if (n > ready) n = ready;
+		memcpy(out + written, ctx->buffer, n);
+		written += n;
+
+		// move the pending samples to the front of the window
+		memmove(ctx->buffer, ctx->buffer + n, ready - n);
+		ctx->outpos -= n;
+		ctx->bufferpos -= n * 50;
+	}
+	return written;
+}
 
-void InsertBreath() {
+void InsertBreath(SamContext *ctx) {
 	unsigned char mem54 = 255;
 	unsigned char len = 0;
 	unsigned char index; //variable Y
 
 	unsigned char pos = 0;
 
-	while((index = phonemeindex[pos]) != END) {
-		len += phonemeLength[pos];
+	while((index = ctx->phonemeindex[pos]) != END) {
+		len += ctx->phonemeLength[pos];
 		if (len < 232) {
 			if (index == BREAK) {
             } else if (!(flags[index] & FLAG_PUNCT)) {
                 if (index == 0) mem54 = pos;
             } else {
                 len = 0;
-                Insert(++pos, BREAK, 0, 0);
+                Insert(ctx, ++pos, BREAK, 0, 0);
             }
 		} else {
             pos = mem54;
-            phonemeindex[pos]  = 31;   // 'Q*' glottal stop
-            phonemeLength[pos] = 4;
-            stress[pos] = 0;
+            ctx->phonemeindex[pos]  = 31;   // 'Q*' glottal stop
+            ctx->phonemeLength[pos] = 4;
+            ctx->stress[pos] = 0;
 
             len = 0;
-            Insert(++pos, BREAK, 0, 0);
+            Insert(ctx, ++pos, BREAK, 0, 0);
         }
         ++pos;
 	}
@@ -195,78 +528,66 @@ void InsertBreath() {
 // For example, the word LOITER is represented as LOY5TER, with as stress
 // of 5 on the dipthong OY. This routine will copy the stress value of 6 (5+1)
 // to the L that precedes it.
-
-
-
-void CopyStress() {
+//
+// In the same pass, the length of each phoneme is set dependent on its
+// final stress. Copying only looks at the phoneme that follows, which has
+// not been visited yet, so this is the same as copying all stress first.
+void SetStressAndLength(SamContext *ctx) {
     // loop thought all the phonemes to be output
 	unsigned char pos=0; //mem66
     unsigned char Y;
-	while((Y = phonemeindex[pos]) != END) {
+	while((Y = ctx->phonemeindex[pos]) != END) {
+		unsigned char A;
+
 		// if CONSONANT_FLAG set, skip - only vowels get stress
 		if (flags[Y] & 64) {
-            Y = phonemeindex[pos+1];
+            unsigned char next = ctx->phonemeindex[pos+1];
 
             // if the following phoneme is the end, or a vowel, skip
-            if (Y != END && (flags[Y] & 128) != 0) {
+            if (next != END && (flags[next] & 128) != 0) {
                 // get the stress value at the next position
-                Y = stress[pos+1];
-                if (Y && !(Y&128)) {
+                A = ctx->stress[pos+1];
+                if (A && !(A&128)) {
                     // if next phoneme is stressed, and a VOWEL OR ER
                     // copy stress from next phoneme to this one
-                    stress[pos] = Y+1;
+                    ctx->stress[pos] = A+1;
                 }
             }
         }
 
+		//change phonemelength depedendent on stress
+		A = ctx->stress[pos];
+		if ((A == 0) || ((A&128) != 0)) {
+			ctx->phonemeLength[pos] = phonemeLengthTable[Y];
+		} else {
+			ctx->phonemeLength[pos] = phonemeStressedLengthTable[Y];
+		}
+
 		++pos;
 	}
 }
 
-void Insert(unsigned char position/*var57*/, unsigned char mem60, unsigned char mem59, unsigned char mem58)
+void Insert(SamContext *ctx, unsigned char position/*var57*/, unsigned char mem60, unsigned char mem59, unsigned char mem58)
 {
-	int i;
-	for(i=253; i >= position; i--) // ML : always keep last safe-guarding 255	
-	{
-		phonemeindex[i+1]  = phonemeindex[i];
-		phonemeLength[i+1] = phonemeLength[i];
-		stress[i+1]        = stress[i];
+	// Only the phonemes up to and including END move, nothing past END is
+	// read. Entry 254 is the last one written. ML : always keep last
+	// safe-guarding 255
+	unsigned char *end = memchr(ctx->phonemeindex + position, END, 255 - position);
+	int count = (end ? (int)(end - ctx->phonemeindex) + 1 : 254) - position;
+	if (position + count > 254) count = 254 - position;
+
+	if (count > 0) {
+		memmove(ctx->phonemeindex + position + 1, ctx->phonemeindex + position, count);
+		memmove(ctx->phonemeLength + position + 1, ctx->phonemeLength + position, count);
+		memmove(ctx->stress + position + 1, ctx->stress + position, count);
 	}
 
-	phonemeindex[position]  = mem60;
-	phonemeLength[position] = mem59;
-	stress[position]        = mem58;
-}
-
-
-signed int full_match(unsigned char sign1, unsigned char sign2) {
-    unsigned char Y = 0;
-    do {
-        // GET FIRST CHARACTER AT POSITION Y IN signInputTable
-        // --> should change name to PhonemeNameTable1
-        unsigned char A = signInputTable1[Y];
-        
-        if (A == sign1) {
-            A = signInputTable2[Y];
-            // NOT A SPECIAL AND MATCHES SECOND CHARACTER?
-            if ((A != '*') && (A == sign2)) return Y;
-        }
-    } while (++Y != 81);
-    return -1;
-}
-
-signed int wild_match(unsigned char sign1) {
-    signed int Y = 0;
-    do {
-		if (signInputTable2[Y] == '*') {
-			if (signInputTable1[Y] == sign1) return Y;
-		}
-	} while (++Y != 81);
-    return -1;
+	ctx->phonemeindex[position]  = mem60;
+	ctx->phonemeLength[position] = mem59;
+	ctx->stress[position]        = mem58;
 }
 
 
-
 // The input[] buffer contains a string of phonemes and stress markers along
 // the lines of:
 //
@@ -318,74 +639,69 @@ signed int wild_match(unsigned char sign1) {
 // The character <0x9B> marks the end of text in input[]. When it is reached,
 // the index 255 is placed at the end of the phonemeIndexTable[], and the
 // function returns with a 1 indicating success.
-int Parser1()
+int Parser1(SamContext *ctx)
 {
 	unsigned char sign1;
 	unsigned char position = 0;
 	unsigned char srcpos   = 0;
 
-	memset(stress, 0, 256); // Clear the stress table.
+	memset(ctx->stress, 0, 256); // Clear the stress table.
+
+	while((sign1 = ctx->input[srcpos]) != 155) { // 155 (\233) is end of line marker
+		unsigned char sign2 = ctx->input[++srcpos];
+		unsigned char match;
+
+		if (sign1 < ' ' || sign1 >= ' ' + 64) return 0; // failure
+		sign2 -= ' ';
+		match = phonemeNames[sign1 - ' '][sign2 < 64 ? sign2 : 64];
 
-	while((sign1 = input[srcpos]) != 155) { // 155 (\233) is end of line marker
-		signed int match;
-		unsigned char sign2 = input[++srcpos];
-        if ((match = full_match(sign1, sign2)) != -1) {
+        if (match < PHONEME_NAME_SINGLE) {
             // Matched both characters (no wildcards)
-            phonemeindex[position++] = (unsigned char)match;
+            ctx->phonemeindex[position++] = match;
             ++srcpos; // Skip the second character of the input as we've matched it
-        } else if ((match = wild_match(sign1)) != -1) {
+        } else if (match < PHONEME_NAME_STRESS) {
             // Matched just the first character (with second character matching '*'
-            phonemeindex[position++] = (unsigned char)match;
+            ctx->phonemeindex[position++] = match & ~PHONEME_NAME_SINGLE;
         } else {
-            // Should be a stress character. Search through the
-            // stress table backwards.
-            match = 8; // End of stress table. FIXME: Don't hardcode.
-            while( (sign1 != stressInputTable[match]) && (match>0) ) --match;
-            
-            if (match == 0) return 0; // failure
+            // Should be a stress character
+            if (match == PHONEME_NAME_NONE) return 0; // failure
 
-            stress[position-1] = (unsigned char)match; // Set stress for prior phoneme
+            ctx->stress[position-1] = match & ~PHONEME_NAME_STRESS; // Set stress for prior phoneme
         }
 	} //while
 
-    phonemeindex[position] = END;
+    ctx->phonemeindex[position] = END;
     return 1;
 }
 
 
-//change phonemelength depedendent on stress
-void SetPhonemeLength() {
-	int position = 0;
-	while(phonemeindex[position] != 255) {
-		unsigned char A = stress[position];
-		if ((A == 0) || ((A&128) != 0)) {
-			phonemeLength[position] = phonemeLengthTable[phonemeindex[position]];
-		} else {
-			phonemeLength[position] = phonemeStressedLengthTable[phonemeindex[position]];
-		}
-		position++;
-	}
-}
-
-void Code41240() {
+// Splits stop consonants into their three parts. Also ends the list at the
+// first phoneme that is not a valid index, which used to be a pass of its
+// own. Everything behind the current phoneme is final by then.
+void Code41240(SamContext *ctx) {
 	unsigned char pos=0;
 
-	while(phonemeindex[pos] != END) {
-		unsigned char index = phonemeindex[pos];
+	while(ctx->phonemeindex[pos] != END) {
+		unsigned char index = ctx->phonemeindex[pos];
+
+		if (index > 80) {
+			ctx->phonemeindex[pos] = END;
+			break; // error: delete all behind it
+		}
 
 		if ((flags[index] & FLAG_STOPCONS)) {
             if ((flags[index] & FLAG_PLOSIVE)) {
                 unsigned char A;
                 unsigned char X = pos;
-                while(!phonemeindex[++X]); /* Skip pause */
-                A = phonemeindex[X];
+                while(!ctx->phonemeindex[++X]); /* Skip pause */
+                A = ctx->phonemeindex[X];
                 if (A != END) {
                     if ((flags[A] & 8) || (A == 36) || (A == 37)) {++pos; continue;} // '/H' '/X'
                 }
                 
             }
-            Insert(pos+1, index+1, phonemeLengthTable[index+1], stress[pos]);
-            Insert(pos+2, index+2, phonemeLengthTable[index+2], stress[pos]);
+            Insert(ctx, pos+1, index+1, phonemeLengthTable[index+1], ctx->stress[pos]);
+            Insert(ctx, pos+2, index+2, phonemeLengthTable[index+2], ctx->stress[pos]);
             pos += 2;
         }
         ++pos;
@@ -393,29 +709,29 @@ void Code41240() {
 }
 
 
-void ChangeRule(unsigned char position, unsigned char mem60, const char * descr)
+void ChangeRule(SamContext *ctx, unsigned char position, unsigned char mem60, const char * descr)
 {
     if (debug) printf("RULE: %s\n",descr);
-    phonemeindex[position] = 13; //rule;
-    Insert(position+1, mem60, 0, stress[position]);
+    ctx->phonemeindex[position] = 13; //rule;
+    Insert(ctx, position+1, mem60, 0, ctx->stress[position]);
 }
 
 void drule(const char * str) {
     if (debug) printf("RULE: %s\n",str);
 }
 
-void drule_pre(const char *descr, unsigned char X) {
+void drule_pre(SamContext *ctx, const char *descr, unsigned char X) {
     drule(descr);
     if (debug) {
         printf("PRE\n");
-        printf("phoneme %d (%c%c) length %d\n", X, signInputTable1[phonemeindex[X]], signInputTable2[phonemeindex[X]], phonemeLength[X]);
+        printf("phoneme %d (%c%c) length %d\n", X, signInputTable1[ctx->phonemeindex[X]], signInputTable2[ctx->phonemeindex[X]], ctx->phonemeLength[X]);
     }
 }
 
-void drule_post(unsigned char X) {
+void drule_post(SamContext *ctx, unsigned char X) {
     if (debug) {
         printf("POST\n");
-        printf("phoneme %d (%c%c) length %d\n", X, signInputTable1[phonemeindex[X]], signInputTable2[phonemeindex[X]], phonemeLength[X]);
+        printf("phoneme %d (%c%c) length %d\n", X, signInputTable1[ctx->phonemeindex[X]], signInputTable2[ctx->phonemeindex[X]], ctx->phonemeLength[X]);
     }
 }
 
@@ -445,46 +761,46 @@ void drule_post(unsigned char X) {
 //       <UNSTRESSED VOWEL> D <PAUSE>  -> <UNSTRESSED VOWEL> DX <PAUSE>
 
 
-void rule_alveolar_uw(unsigned char X) {
+void rule_alveolar_uw(SamContext *ctx, unsigned char X) {
     // ALVEOLAR flag set?
-    if (flags[phonemeindex[X-1]] & FLAG_ALVEOLAR) {
+    if (flags[ctx->phonemeindex[X-1]] & FLAG_ALVEOLAR) {
         drule("<ALVEOLAR> UW -> <ALVEOLAR> UX");
-        phonemeindex[X] = 16;
+        ctx->phonemeindex[X] = 16;
     }
 }
 
-void rule_ch(unsigned char X) {
+void rule_ch(SamContext *ctx, unsigned char X) {
     drule("CH -> CH CH+1");
-    Insert(X+1, 43, 0, stress[X]);
+    Insert(ctx, X+1, 43, 0, ctx->stress[X]);
 }
 
-void rule_j(unsigned char X) {
+void rule_j(SamContext *ctx, unsigned char X) {
     drule("J -> J J+1");
-    Insert(X+1, 45, 0, stress[X]);
+    Insert(ctx, X+1, 45, 0, ctx->stress[X]);
 }
 
-void rule_g(unsigned char pos) {
+void rule_g(SamContext *ctx, unsigned char pos) {
     // G <VOWEL OR DIPTHONG NOT ENDING WITH IY> -> GX <VOWEL OR DIPTHONG NOT ENDING WITH IY>
     // Example: GO
 
-    unsigned char index = phonemeindex[pos+1];
+    unsigned char index = ctx->phonemeindex[pos+1];
             
     // If dipthong ending with YX, move continue processing next phoneme
     if ((index != 255) && ((flags[index] & FLAG_DIP_YX) == 0)) {
         // replace G with GX and continue processing next phoneme
         drule("G <VOWEL OR DIPTHONG NOT ENDING WITH IY> -> GX <VOWEL OR DIPTHONG NOT ENDING WITH IY>");
-        phonemeindex[pos] = 63; // 'GX'
+        ctx->phonemeindex[pos] = 63; // 'GX'
     }
 }
 
 
-void change(unsigned char pos, unsigned char val, const char * rule) {
+void change(SamContext *ctx, unsigned char pos, unsigned char val, const char * rule) {
     drule(rule);
-    phonemeindex[pos] = val;
+    ctx->phonemeindex[pos] = val;
 }
 
 
-void rule_dipthong(unsigned char p, unsigned short pf, unsigned char pos) {
+void rule_dipthong(SamContext *ctx, unsigned char p, unsigned short pf, unsigned char pos) {
     // <DIPTHONG ENDING WITH WX> -> <DIPTHONG ENDING WITH WX> WX
     // <DIPTHONG NOT ENDING WITH WX> -> <DIPTHONG NOT ENDING WITH WX> YX
     // Example: OIL, COW
@@ -495,20 +811,27 @@ void rule_dipthong(unsigned char p, unsigned short pf, unsigned char pos) {
     // Insert at WX or YX following, copying the stress
     if (A==20) drule("insert WX following dipthong NOT ending in IY sound");
     else if (A==21) drule("insert YX following dipthong ending in IY sound");
-    Insert(pos+1, A, 0, stress[pos]);
+    Insert(ctx, pos+1, A, 0, ctx->stress[pos]);
                 
-    if (p == 53) rule_alveolar_uw(pos); // Example: NEW, DEW, SUE, ZOO, THOO, TOO
-    else if (p == 42) rule_ch(pos);     // Example: CHEW
-    else if (p == 44) rule_j(pos);      // Example: JAY
+    if (p == 53) rule_alveolar_uw(ctx, pos); // Example: NEW, DEW, SUE, ZOO, THOO, TOO
+    else if (p == 42) rule_ch(ctx, pos);     // Example: CHEW
+    else if (p == 44) rule_j(ctx, pos);      // Example: JAY
+}
+
+// Flags of a phoneme. END is not in the flags table; it has no flags,
+// which is what the original engine read past the end of the table.
+static unsigned short PhonemeFlags(unsigned char index)
+{
+	return index == END ? 0 : flags[index];
 }
 
-void Parser2() {
+void Parser2(SamContext *ctx) {
 	unsigned char pos = 0; //mem66;
     unsigned char p;
 
 	if (debug) printf("Parser2\n");
 
-	while((p = phonemeindex[pos]) != END) {
+	while((p = ctx->phonemeindex[pos]) != END) {
 		unsigned short pf;
 		unsigned char prior;
 
@@ -520,42 +843,42 @@ void Parser2() {
 		}
 
         pf = flags[p];
-        prior = phonemeindex[pos-1];
+        prior = pos ? ctx->phonemeindex[pos-1] : 0; // a pause before the first
 
-        if ((pf & FLAG_DIPTHONG)) rule_dipthong(p, pf, pos);
-        else if (p == 78) ChangeRule(pos, 24, "UL -> AX L"); // Example: MEDDLE
-        else if (p == 79) ChangeRule(pos, 27, "UM -> AX M"); // Example: ASTRONOMY
-        else if (p == 80) ChangeRule(pos, 28, "UN -> AX N"); // Example: FUNCTION
-        else if ((pf & FLAG_VOWEL) && stress[pos]) {
+        if ((pf & FLAG_DIPTHONG)) rule_dipthong(ctx, p, pf, pos);
+        else if (p == 78) ChangeRule(ctx, pos, 24, "UL -> AX L"); // Example: MEDDLE
+        else if (p == 79) ChangeRule(ctx, pos, 27, "UM -> AX M"); // Example: ASTRONOMY
+        else if (p == 80) ChangeRule(ctx, pos, 28, "UN -> AX N"); // Example: FUNCTION
+        else if ((pf & FLAG_VOWEL) && ctx->stress[pos]) {
             // RULE:
             //       <STRESSED VOWEL> <SILENCE> <STRESSED VOWEL> -> <STRESSED VOWEL> <SILENCE> Q <VOWEL>
             // EXAMPLE: AWAY EIGHT
-            if (!phonemeindex[pos+1]) { // If following phoneme is a pause, get next
-                p = phonemeindex[pos+2];
-                if (p!=END && (flags[p] & FLAG_VOWEL) && stress[pos+2]) {
+            if (!ctx->phonemeindex[pos+1]) { // If following phoneme is a pause, get next
+                p = ctx->phonemeindex[pos+2];
+                if (p!=END && (flags[p] & FLAG_VOWEL) && ctx->stress[pos+2]) {
                     drule("Insert glottal stop between two stressed vowels with space between them");
-                    Insert(pos+2, 31, 0, 0); // 31 = 'Q'
+                    Insert(ctx, pos+2, 31, 0, 0); // 31 = 'Q'
                 }
             }
         } else if (p == pR) { // RULES FOR PHONEMES BEFORE R
-            if (prior == pT) change(pos-1,42, "T R -> CH R"); // Example: TRACK
-            else if (prior == pD) change(pos-1,44, "D R -> J R"); // Example: DRY
-            else if (flags[prior] & FLAG_VOWEL) change(pos, 18, "<VOWEL> R -> <VOWEL> RX"); // Example: ART
-        } else if (p == 24 && (flags[prior] & FLAG_VOWEL)) change(pos, 19, "<VOWEL> L -> <VOWEL> LX"); // Example: ALL
+            if (prior == pT) change(ctx, pos-1,42, "T R -> CH R"); // Example: TRACK
+            else if (prior == pD) change(ctx, pos-1,44, "D R -> J R"); // Example: DRY
+            else if (flags[prior] & FLAG_VOWEL) change(ctx, pos, 18, "<VOWEL> R -> <VOWEL> RX"); // Example: ART
+        } else if (p == 24 && (flags[prior] & FLAG_VOWEL)) change(ctx, pos, 19, "<VOWEL> L -> <VOWEL> LX"); // Example: ALL
         else if (prior == 60 && p == 32) { // 'G' 'S'
             // Can't get to fire -
             //       1. The G -> GX rule intervenes
             //       2. Reciter already replaces GS -> GZ
-            change(pos, 38, "G S -> G Z");
-        } else if (p == 60) rule_g(pos);
+            change(ctx, pos, 38, "G S -> G Z");
+        } else if (p == 60) rule_g(ctx, pos);
 		else {
             if (p == 72) {  // 'K'
                 // K <VOWEL OR DIPTHONG NOT ENDING WITH IY> -> KX <VOWEL OR DIPTHONG NOT ENDING WITH IY>
                 // Example: COW
-                unsigned char Y = phonemeindex[pos+1];
+                unsigned char Y = ctx->phonemeindex[pos+1];
                 // If at end, replace current phoneme with KX
-                if ((flags[Y] & FLAG_DIP_YX)==0 || Y==END) { // VOWELS AND DIPTHONGS ENDING WITH IY SOUND flag set?
-                    change(pos, 75, "K <VOWEL OR DIPTHONG NOT ENDING WITH IY> -> KX <VOWEL OR DIPTHONG NOT ENDING WITH IY>");
+                if (Y == END || (flags[Y] & FLAG_DIP_YX) == 0) { // VOWELS AND DIPTHONGS ENDING WITH IY SOUND flag set?
+                    change(ctx, pos, 75, "K <VOWEL OR DIPTHONG NOT ENDING WITH IY> -> KX <VOWEL OR DIPTHONG NOT ENDING WITH IY>");
                     p  = 75;
                     pf = flags[p];
                 }
@@ -571,12 +894,12 @@ void Parser2() {
                 // Examples: SPY, STY, SKY, SCOWL
                 
                 if (debug) printf("RULE: S* %c%c -> S* %c%c\n", signInputTable1[p], signInputTable2[p],signInputTable1[p-12], signInputTable2[p-12]);
-                phonemeindex[pos] = p-12;
+                ctx->phonemeindex[pos] = p-12;
             } else if (!(pf & FLAG_PLOSIVE)) {
-                p = phonemeindex[pos];
-                if (p == 53) rule_alveolar_uw(pos);   // Example: NEW, DEW, SUE, ZOO, THOO, TOO
-                else if (p == 42) rule_ch(pos); // Example: CHEW
-                else if (p == 44) rule_j(pos);  // Example: JAY
+                p = ctx->phonemeindex[pos];
+                if (p == 53) rule_alveolar_uw(ctx, pos);   // Example: NEW, DEW, SUE, ZOO, THOO, TOO
+                else if (p == 42) rule_ch(ctx, pos); // Example: CHEW
+                else if (p == 44) rule_j(ctx, pos);  // Example: JAY
             }
             
             if (p == 69 || p == 57) { // 'T', 'D'
@@ -585,10 +908,10 @@ void Parser2() {
                 //       <UNSTRESSED VOWEL> T <PAUSE> -> <UNSTRESSED VOWEL> DX <PAUSE>
                 //       <UNSTRESSED VOWEL> D <PAUSE>  -> <UNSTRESSED VOWEL> DX <PAUSE>
                 // Example: PARTY, TARDY
-                if (flags[phonemeindex[pos-1]] & FLAG_VOWEL) {
-                    p = phonemeindex[pos+1];
-                    if (!p) p = phonemeindex[pos+2];
-                    if ((flags[p] & FLAG_VOWEL) && !stress[pos+1]) change(pos,30, "Soften T or D following vowel or ER and preceding a pause -> DX");
+                if (flags[ctx->phonemeindex[pos-1]] & FLAG_VOWEL) {
+                    p = ctx->phonemeindex[pos+1];
+                    if (!p) p = ctx->phonemeindex[pos+2];
+                    if ((PhonemeFlags(p) & FLAG_VOWEL) && !ctx->stress[pos+1]) change(ctx, pos,30, "Soften T or D following vowel or ER and preceding a pause -> DX");
                 }
             }
         }
@@ -606,7 +929,7 @@ void Parser2() {
 //         <VOICED STOP CONSONANT> {optional silence} <STOP CONSONANT> - shorten both to 1/2 + 1
 //         <LIQUID CONSONANT> <DIPTHONG> - decrease by 2
 //
-void AdjustLengths() {
+void AdjustLengths(SamContext *ctx) {
     // LENGTHEN VOWELS PRECEDING PUNCTUATION
     //
     // Search for punctuation. If found, back up to the first vowel, then
@@ -619,7 +942,7 @@ void AdjustLengths() {
 	unsigned char X = 0;
 	unsigned char index;
 
-	while((index = phonemeindex[X]) != END) {
+	while((index = ctx->phonemeindex[X]) != END) {
 		unsigned char loopIndex;
 
 		// not punctuation?
@@ -630,20 +953,20 @@ void AdjustLengths() {
 
 		loopIndex = X;
 
-        while (--X && !(flags[phonemeindex[X]] & FLAG_VOWEL)); // back up while not a vowel
+        while (--X && !(flags[ctx->phonemeindex[X]] & FLAG_VOWEL)); // back up while not a vowel
         if (X == 0) break;
 
 		do {
             // test for vowel
-			index = phonemeindex[X];
+			index = ctx->phonemeindex[X];
 
 			// test for fricative/unvoiced or not voiced
 			if(!(flags[index] & FLAG_FRICATIVE) || (flags[index] & FLAG_VOICED)) {     //nochmal berprfen
-				unsigned char A = phonemeLength[X];
+				unsigned char A = ctx->phonemeLength[X];
 				// change phoneme length to (length * 1.5) + 1
-                drule_pre("Lengthen <FRICATIVE> or <VOICED> between <VOWEL> and <PUNCTUATION> by 1.5",X);
-				phonemeLength[X] = (A >> 1) + A + 1;
-                drule_post(X);
+                drule_pre(ctx, "Lengthen <FRICATIVE> or <VOICED> between <VOWEL> and <PUNCTUATION> by 1.5",X);
+				ctx->phonemeLength[X] = (A >> 1) + A + 1;
+                drule_post(ctx, X);
 			}
 		} while (++X != loopIndex);
 		X++;
@@ -656,78 +979,78 @@ void AdjustLengths() {
 	unsigned char loopIndex=0;
 	unsigned char index;
 
-	while((index = phonemeindex[loopIndex]) != END) {
+	while((index = ctx->phonemeindex[loopIndex]) != END) {
 		unsigned char X = loopIndex;
 
 		if (flags[index] & FLAG_VOWEL) {
-			index = phonemeindex[loopIndex+1];
-			if (!(flags[index] & FLAG_CONSONANT)) {
+			index = ctx->phonemeindex[loopIndex+1];
+			if (!(PhonemeFlags(index) & FLAG_CONSONANT)) {
 				if ((index == 18) || (index == 19)) { // 'RX', 'LX'
-					index = phonemeindex[loopIndex+2];
-					if ((flags[index] & FLAG_CONSONANT)) {
-                        drule_pre("<VOWEL> <RX | LX> <CONSONANT> - decrease length of vowel by 1\n", loopIndex);
-    					phonemeLength[loopIndex]--;
-                        drule_post(loopIndex);
+					index = ctx->phonemeindex[loopIndex+2];
+					if ((PhonemeFlags(index) & FLAG_CONSONANT)) {
+                        drule_pre(ctx, "<VOWEL> <RX | LX> <CONSONANT> - decrease length of vowel by 1\n", loopIndex);
+    					ctx->phonemeLength[loopIndex]--;
+                        drule_post(ctx, loopIndex);
                     }
 				}
 			} else { // Got here if not <VOWEL>
-                unsigned short flag = (index == END) ? 65 : flags[index]; // 65 if end marker
+                unsigned short flag = PhonemeFlags(index);
 
                 if (!(flag & FLAG_VOICED)) { // Unvoiced
                     // *, .*, ?*, ,*, -*, DX, S*, SH, F*, TH, /H, /X, CH, P*, T*, K*, KX
                     if((flag & FLAG_PLOSIVE)) { // unvoiced plosive
                         // RULE: <VOWEL> <UNVOICED PLOSIVE>
                         // <VOWEL> <P*, T*, K*, KX>
-                        drule_pre("<VOWEL> <UNVOICED PLOSIVE> - decrease vowel by 1/8th",loopIndex);
-                        phonemeLength[loopIndex] -= (phonemeLength[loopIndex] >> 3);
-                        drule_post(loopIndex);
+                        drule_pre(ctx, "<VOWEL> <UNVOICED PLOSIVE> - decrease vowel by 1/8th",loopIndex);
+                        ctx->phonemeLength[loopIndex] -= (ctx->phonemeLength[loopIndex] >> 3);
+                        drule_post(ctx, loopIndex);
                     }
                 } else {
                     unsigned char A;
-                    drule_pre("<VOWEL> <VOICED CONSONANT> - increase vowel by 1/2 + 1\n",X-1);
+                    drule_pre(ctx, "<VOWEL> <VOICED CONSONANT> - increase vowel by 1/2 + 1\n",X-1);
                     // decrease length
-                    A = phonemeLength[loopIndex];
-                    phonemeLength[loopIndex] = (A >> 2) + A + 1;     // 5/4*A + 1
-                    drule_post(loopIndex);
+                    A = ctx->phonemeLength[loopIndex];
+                    ctx->phonemeLength[loopIndex] = (A >> 2) + A + 1;     // 5/4*A + 1
+                    drule_post(ctx, loopIndex);
                 }
             }
 		} else if((flags[index] & FLAG_NASAL) != 0) { // nasal?
             // RULE: <NASAL> <STOP CONSONANT>
             //       Set punctuation length to 6
             //       Set stop consonant length to 5
-            index = phonemeindex[++X];
+            index = ctx->phonemeindex[++X];
             if (index != END && (flags[index] & FLAG_STOPCONS)) {
                 drule("<NASAL> <STOP CONSONANT> - set nasal = 5, consonant = 6");
-                phonemeLength[X]   = 6; // set stop consonant length to 6
-                phonemeLength[X-1] = 5; // set nasal length to 5
+                ctx->phonemeLength[X]   = 6; // set stop consonant length to 6
+                ctx->phonemeLength[X-1] = 5; // set nasal length to 5
             }
         } else if((flags[index] & FLAG_STOPCONS)) { // (voiced) stop consonant?
             // RULE: <VOICED STOP CONSONANT> {optional silence} <STOP CONSONANT>
             //       Shorten both to (length/2 + 1)
 
             // move past silence
-            while ((index = phonemeindex[++X]) == 0);
+            while ((index = ctx->phonemeindex[++X]) == 0);
 
             if (index != END && (flags[index] & FLAG_STOPCONS)) {
                 // FIXME, this looks wrong?
                 // RULE: <UNVOICED STOP CONSONANT> {optional silence} <STOP CONSONANT>
                 drule("<UNVOICED STOP CONSONANT> {optional silence} <STOP CONSONANT> - shorten both to 1/2 + 1");
-                phonemeLength[X]         = (phonemeLength[X] >> 1) + 1;
-                phonemeLength[loopIndex] = (phonemeLength[loopIndex] >> 1) + 1;
+                ctx->phonemeLength[X]         = (ctx->phonemeLength[X] >> 1) + 1;
+                ctx->phonemeLength[loopIndex] = (ctx->phonemeLength[loopIndex] >> 1) + 1;
                 X = loopIndex;
             }
         } else if ((flags[index] & FLAG_LIQUIC)) { // liquic consonant?
             // RULE: <VOICED NON-VOWEL> <DIPTHONG>
             //       Decrease <DIPTHONG> by 2
-            index = phonemeindex[X-1]; // prior phoneme;
+            index = ctx->phonemeindex[X-1]; // prior phoneme;
 
             // FIXME: The debug code here breaks the rule.
             // prior phoneme a stop consonant>
             if((flags[index] & FLAG_STOPCONS) != 0) 
-                drule_pre("<LIQUID CONSONANT> <DIPTHONG> - decrease by 2",X);
+                drule_pre(ctx, "<LIQUID CONSONANT> <DIPTHONG> - decrease by 2",X);
             
-            phonemeLength[X] -= 2; // 20ms
-            drule_post(X);
+            ctx->phonemeLength[X] -= 2; // 20ms
+            drule_post(ctx, X);
          }
 
         ++loopIndex;
@@ -1,6 +1,69 @@
 #ifndef SAM_H
 #define SAM_H
 
+// Opaque engine state. Every context owns its own phoneme tables, frame
+// tables and output buffer, so independent contexts may render
+// concurrently on different threads.
+typedef struct SamContext SamContext;
+
+SamContext* SamCreateContext();
+void SamDestroyContext(SamContext *ctx);
+
+void SamSetInput(SamContext *ctx, unsigned char *_input);
+void SamSetSpeed(SamContext *ctx, unsigned char _speed);
+void SamSetPitch(SamContext *ctx, unsigned char _pitch);
+void SamSetMouth(SamContext *ctx, unsigned char _mouth);
+void SamSetThroat(SamContext *ctx, unsigned char _throat);
+void SamEnableSingmode(SamContext *ctx, int _singmode);
+
+int SamMain(SamContext *ctx);
+
+char* SamGetBuffer(SamContext *ctx);
+int SamGetBufferLength(SamContext *ctx);
+
+// Output storage. By default the context owns its buffer and grows it as a
+// phrase needs more room. A caller can supply its own storage instead:
+// alloc is called with the buffer in use (NULL on the first call of a
+// render) and the number of bytes required, and must return storage of at
+// least that size which keeps the samples already written. It returns NULL
+// to make the render fail. The engine never frees caller storage. Passing
+// a NULL alloc goes back to the context owned buffer.
+typedef char* (*SamBufferAlloc)(void *user, char *buffer, int size);
+void SamSetBufferAlloc(SamContext *ctx, SamBufferAlloc alloc, void *user);
+
+// Streaming synthesis. SamStreamBegin parses the input given to SamSetInput,
+// then each SamStreamRead call renders the next samples (unsigned 8 bit at
+// 22050 Hz) into out. SamStreamRead returns fewer than count samples only
+// once the phrase has ended. The concatenated output is identical to the
+// SamGetBuffer result of SamMain.
+int SamStreamBegin(SamContext *ctx);
+int SamStreamRead(SamContext *ctx, unsigned char *out, int count);
+
+// Parsed input. SamParse runs the phoneme rules over the input given to
+// SamSetInput and keeps the phoneme, length and stress lists that
+// rendering starts from. These do not depend on speed, pitch, mouth,
+// throat or sing mode, so a phrase can be rendered again with other voice
+// settings without parsing it again. SamRenderPhrase and
+// SamStreamBeginPhrase work like SamMain and SamStreamBegin and give the
+// same output. The phrase is read while rendering, so it must outlive the
+// render or stream, and may be shared by contexts on different threads.
+// SamParse returns NULL when out of memory.
+typedef struct SamPhrase SamPhrase;
+
+SamPhrase* SamParse(SamContext *ctx);
+void SamDestroyPhrase(SamPhrase *phrase);
+int SamRenderPhrase(SamContext *ctx, const SamPhrase *phrase);
+int SamStreamBeginPhrase(SamContext *ctx, const SamPhrase *phrase);
+
+// Cancellation. Renders call cancelled between frames and the reciter calls
+// it between words; once it returns nonzero the render or recitation stops
+// and fails. It runs on the rendering thread, so it should only read a flag
+// or a counter. Passing NULL turns checking off.
+typedef int (*SamCancelCheck)(void *user);
+void SamSetCancelCheck(SamContext *ctx, SamCancelCheck cancelled, void *user);
+
+// Single-context API used by the command line tool. These operate on a
+// process-wide default context and are not thread safe.
 void SetInput(unsigned char *_input);
 void SetSpeed(unsigned char _speed);
 void SetPitch(unsigned char _pitch);
@@ -0,0 +1,122 @@
+#ifndef SAMCONTEXT_H
+#define SAMCONTEXT_H
+
+#include "sam.h"
+
+// Loop variables of ProcessFrames, kept between calls so rendering can be
+// suspended and resumed at any glottal tick.
+typedef struct
+{
+	unsigned char mem48; // frames left
+	unsigned char speedcounter;
+	unsigned char phase1;
+	unsigned char phase2;
+	unsigned char phase3;
+	unsigned char mem66;
+	unsigned char Y; // current frame
+	unsigned char glottal_pulse;
+	unsigned char mem38;
+} ProcessFramesState;
+
+// Full state of one SAM engine. This replaces what used to be process-wide
+// globals in reciter.c, sam.c, render.c, createtransitions.c and
+// processframes.c. Only the engine sources include this header, callers
+// see SamContext as an opaque type.
+struct SamContext
+{
+	// reciter registers and working copy of the text
+	unsigned char A, X;
+	unsigned char inputtemp[256];   // secure copy of input tab36096
+
+	// voice settings
+	unsigned char speed;
+	unsigned char pitch;
+	unsigned char mouth;
+	unsigned char throat;
+	int singmode;
+
+	// complete phoneme input given to SamSetInput, ending in 155. It is
+	// parsed one piece at a time.
+	unsigned char *text;
+	int textlength;
+	int textsize;
+	int textpos; // start of the next piece
+	int inputfailed; // set when a piece did not parse
+
+	// parsed phrase being rendered instead of text, see SamRenderPhrase,
+	// and the start of its next segment
+	const SamPhrase *phrase;
+	int phrasepos;
+
+	// phoneme input and parser tables for the current piece
+	unsigned char input[256]; //tab39445
+	unsigned char stress[256]; //numbers from 0 to 8
+	unsigned char phonemeLength[256]; //tab40160
+	unsigned char phonemeindex[256];
+
+	unsigned char phonemeIndexOutput[256]; //tab47296
+	unsigned char stressOutput[256]; //tab47365
+	unsigned char phonemeLengthOutput[256]; //tab47416
+
+	// formant frequencies for the current mouth and throat, rows of the
+	// shared tables in RenderTabs.h picked by SetMouthThroat
+	const unsigned char *freq1data;
+	const unsigned char *freq2data;
+
+	// frame tables
+	unsigned char pitches[256]; // tab43008
+
+	unsigned char frequency1[256];
+	unsigned char frequency2[256];
+	unsigned char frequency3[256];
+
+	unsigned char amplitude1[256];
+	unsigned char amplitude2[256];
+	unsigned char amplitude3[256];
+
+	unsigned char sampledConsonantFlag[256]; // tab44800
+
+	// Frames written since the context was created, set by CreateFrames
+	// and interpolate. All frames from here on are still 0. It is not
+	// reset per segment: transitions can read frames an earlier, longer
+	// segment left past the end of this one, and the original engine
+	// rescaled and contoured those again for every segment.
+	int framesUsed;
+
+	// see SamSetCancelCheck; cancelled is set once the check has fired
+	// during the current render
+	SamCancelCheck cancelcheck;
+	void *canceluser;
+	int cancelled;
+
+	// output progress: next phoneme of the current piece for PrepareOutput
+	// and the frame loop
+	unsigned char srcpos;
+	int outputDone;
+	int segmentActive;
+	ProcessFramesState frameState;
+
+	// contains the final soundbuffer
+	int bufferpos; // in C64 cycles, 50 per sample
+	char *buffer;
+	int buffersize;
+	int bufferfailed; // set when the buffer could not grow
+	SamBufferAlloc bufferalloc; // NULL when the context owns buffer
+	void *bufferuser;
+	int outpos; // samples written to buffer
+	unsigned char lastsample;
+	unsigned oldtimetableindex;
+};
+
+// Context used by the single-context API (SetInput, SAMMain, TextToPhonemes, ...).
+SamContext* SamDefaultContext();
+
+// Makes room for at least size bytes in ctx->buffer. Returns 0 and sets
+// bufferfailed if that is not possible.
+int SamReserveBuffer(SamContext *ctx, int size);
+
+// Asks the cancel check, if any. Returns nonzero if the current render has
+// been cancelled.
+int SamCancelled(SamContext *ctx);
+
+#endif
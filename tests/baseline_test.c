@@ -0,0 +1,46 @@
+// Phoneme input whose renders have drifted from the original engine, with
+// the FNV-1a hash of the samples the original engine gives them. Each
+// case is rendered on a fresh context and then again on the same one.
+
+#include "test_util.h"
+
+static const struct
+{
+    const char *phonemes;
+    unsigned int hash;
+} kCases[] = {
+    // the first phoneme is wider than its end, so its pitch transition
+    // starts before frame 0
+    { "OYF4 /X1UH4VAO4/HAX1UX5IY1 V4AW WH5 EHJAY4AH1 SH5SH5WH4S,L-/HN1TH?WHDXUW1 ", 0x1AE65B3D },
+    // a transition reads frames past the end of a segment, left there by
+    // a longer one before it
+    { "NX1P5.WX5 T5AO5 WX YX4 T1IH1 RX5?IHRX AO5UWYX-W4-AYOYIY4LXZ4SVTH", 0x76848577 },
+};
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+int main()
+{
+    unsigned char *input = malloc(256);
+    int t, k;
+
+    for (t = 0; t < COUNT(kCases); t++) {
+        SamContext *ctx = SamCreateContext();
+
+        memset(input, 0, 256);
+        strcpy((char*)input, kCases[t].phonemes);
+        strcat((char*)input, "\x9b");
+        for (k = 0; k < 2; k++) {
+            Render r;
+            SamSetInput(ctx, input);
+            r = TakeRender(ctx, SamMain(ctx));
+            CHECK(r.ok && Hash(&r) == kCases[t].hash, "case %d, render %d: hash 0x%08X", t, k, Hash(&r));
+            free(r.samples);
+        }
+        SamDestroyContext(ctx);
+    }
+
+    free(input);
+    if (failures) printf("%d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,27 @@
+// The premultiplied formant tables in RenderTabs.h hold what the formant
+// run used to look up in multtable for every amplitude up to 15.
+
+#include <stdio.h>
+
+#include "RenderTabs.h"
+
+int main()
+{
+    int failures = 0;
+    int amplitude, phase;
+
+    for (amplitude = 0; amplitude < 16; amplitude++) {
+        for (phase = 0; phase < 256; phase++) {
+            if (sineAmplitude[amplitude][phase] != multtable[sinus[phase] | amplitude]) {
+                printf("sine amplitude %d phase %d differs\n", amplitude, phase);
+                failures++;
+            }
+            if (rectangleAmplitude[amplitude][phase] != multtable[rectangle[phase] | amplitude]) {
+                printf("rectangle amplitude %d phase %d differs\n", amplitude, phase);
+                failures++;
+            }
+        }
+    }
+    if (failures) printf("%d failures\n", failures);
+    return failures != 0;
+}
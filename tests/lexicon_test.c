@@ -0,0 +1,81 @@
+// Lexicon parsing and lookup.
+
+#include "test_util.h"
+#include "lexicon.h"
+
+static const char kText[] =
+    "# comment line\n"
+    "\n"
+    "SAM      SAE4M\n"
+    "iplug\tAY4PLAHG\r\n"
+    "   \n"
+    "NOPHONEMES\n"
+    "VST  VIY EHS TIY\n"
+    "SAM SAE5M\n"
+    "LAST /HAE4PIY";
+
+static int Is(const SamLexicon *lex, const char *word, const char *phonemes)
+{
+    const char *found = SamLexiconLookup(lex, word, strlen(word));
+    if (phonemes == NULL) return found == NULL;
+    return found != NULL && strcmp(found, phonemes) == 0;
+}
+
+int main()
+{
+    SamLexicon *lex = SamParseLexicon(kText, strlen(kText));
+    char name[64];
+    char word[16];
+    char *big;
+    FILE *file;
+    int i;
+
+    CHECK(lex != NULL, "parse failed");
+    CHECK(SamLexiconSize(lex) == 4, "size %d, want 4", SamLexiconSize(lex));
+    CHECK(Is(lex, "SAM", "SAE5M"), "later entry does not replace earlier");
+    CHECK(Is(lex, "sam", "SAE5M") && Is(lex, "Sam", "SAE5M"), "lookup is case sensitive");
+    CHECK(Is(lex, "IPLUG", "AY4PLAHG"), "lower case word or CRLF line");
+    CHECK(Is(lex, "VST", "VIY EHS TIY"), "phonemes with spaces");
+    CHECK(Is(lex, "LAST", "/HAE4PIY"), "last line without newline");
+    CHECK(Is(lex, "NOPHONEMES", NULL), "line without phonemes was kept");
+    CHECK(Is(lex, "SA", NULL) && Is(lex, "SAMS", NULL) && Is(lex, "HELLO", NULL), "missing word found");
+    CHECK(SamLexiconLookup(lex, "SAMS", 3) != NULL, "length is not honoured");
+    SamDestroyLexicon(lex);
+
+    lex = SamParseLexicon("", 0);
+    CHECK(lex != NULL && SamLexiconSize(lex) == 0, "empty text");
+    SamDestroyLexicon(lex);
+
+    // enough entries to grow the table
+    big = malloc(5000 * 24);
+    big[0] = 0;
+    for (i = 0; i < 5000; i++) sprintf(big + strlen(big), "W%d AH%d\n", i, i % 9);
+    lex = SamParseLexicon(big, strlen(big));
+    CHECK(lex != NULL && SamLexiconSize(lex) == 5000, "large lexicon size");
+    for (i = 0; lex != NULL && i < 5000; i++) {
+        char want[8];
+        sprintf(word, "w%d", i);
+        sprintf(want, "AH%d", i % 9);
+        CHECK(Is(lex, word, want), "large lexicon lookup of %s", word);
+    }
+    SamDestroyLexicon(lex);
+    free(big);
+
+    // the same text loaded from a file
+    sprintf(name, "lexicon_test_%d.txt", (int)(rand() % 100000));
+    file = fopen(name, "wb");
+    CHECK(file != NULL, "cannot write %s", name);
+    if (file != NULL) {
+        fwrite(kText, 1, strlen(kText), file);
+        fclose(file);
+        lex = SamLoadLexicon(name);
+        remove(name);
+        CHECK(lex != NULL && SamLexiconSize(lex) == 4, "loaded lexicon");
+        CHECK(lex != NULL && Is(lex, "IPLUG", "AY4PLAHG"), "loaded lookup");
+        SamDestroyLexicon(lex);
+    }
+    CHECK(SamLoadLexicon("no/such/lexicon.txt") == NULL, "missing file loaded");
+
+    if (failures) printf("%d failures\n", failures);
+    return failures != 0;
+}
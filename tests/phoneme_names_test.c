@@ -0,0 +1,108 @@
+// The phoneme name table in PhonemeNameTabs.h matches what full_match,
+// wild_match and a search of stressInputTable make of each pair of input
+// characters. Run with "print" to write a new table to stdout instead,
+// after the name tables in SamTabs.h have changed.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "SamTabs.h"
+#include "PhonemeNameTabs.h"
+
+static unsigned char computed[64][65];
+
+static int FullMatch(unsigned char sign1, unsigned char sign2)
+{
+    int Y;
+    for (Y = 0; Y < 81; Y++) {
+        if (signInputTable1[Y] == sign1 && signInputTable2[Y] != '*' && signInputTable2[Y] == sign2) return Y;
+    }
+    return -1;
+}
+
+static int WildMatch(unsigned char sign1)
+{
+    int Y;
+    for (Y = 0; Y < 81; Y++) {
+        if (signInputTable2[Y] == '*' && signInputTable1[Y] == sign1) return Y;
+    }
+    return -1;
+}
+
+static void Compute()
+{
+    int sign1, sign2;
+
+    for (sign1 = 0; sign1 < 64; sign1++) {
+        for (sign2 = 0; sign2 < 65; sign2++) {
+            unsigned char value = PHONEME_NAME_NONE;
+            int match = -1;
+
+            if (sign2 < 64) match = FullMatch(sign1 + ' ', sign2 + ' ');
+            if (match != -1) {
+                value = (unsigned char)match;
+            } else if ((match = WildMatch(sign1 + ' ')) != -1) {
+                value = PHONEME_NAME_SINGLE | match;
+            } else {
+                match = 8;
+                while (sign1 + ' ' != stressInputTable[match] && match > 0) --match;
+                if (match != 0) value = PHONEME_NAME_STRESS | match;
+            }
+            computed[sign1][sign2] = value;
+        }
+    }
+}
+
+static void Print()
+{
+    int sign1, sign2;
+
+    printf("#ifndef PHONEMENAMETABS_H\n");
+    printf("#define PHONEMENAMETABS_H\n\n");
+    printf("// Values of phonemeNames: a phoneme index below PHONEME_NAME_SINGLE\n");
+    printf("// matches both characters, PHONEME_NAME_SINGLE | index only the first,\n");
+    printf("// PHONEME_NAME_STRESS | stress is a stress mark.\n");
+    printf("#define PHONEME_NAME_SINGLE 128\n");
+    printf("#define PHONEME_NAME_STRESS 224\n");
+    printf("#define PHONEME_NAME_NONE   255\n\n");
+    printf("// What Parser1 makes of two input characters, indexed by the first and\n");
+    printf("// second character minus ' '. All phoneme names and stress marks lie\n");
+    printf("// between ' ' and '_'; any other second character uses the last column.\n");
+    printf("// Generated by tests/phoneme_names_test.c from the tables in SamTabs.h.\n");
+    printf("const unsigned char phonemeNames[64][65] =\n{\n");
+    for (sign1 = 0; sign1 < 64; sign1++) {
+        // a backslash would continue the comment onto the next line
+        if (sign1 + ' ' == '\\') printf("\t// backslash\n\t{");
+        else printf("\t// '%c'\n\t{", sign1 + ' ');
+        for (sign2 = 0; sign2 < 65; sign2++) {
+            if (sign2 % 16 == 0) printf("\n\t\t");
+            printf("0x%02X%s", computed[sign1][sign2], sign2 == 64 ? "" : (sign2 % 16 == 15 ? "," : ", "));
+        }
+        printf("\n\t},\n");
+    }
+    printf("};\n\n");
+    printf("#endif\n");
+}
+
+int main(int argc, char **argv)
+{
+    int failures = 0;
+    int sign1, sign2;
+
+    Compute();
+    if (argc > 1 && strcmp(argv[1], "print") == 0) {
+        Print();
+        return 0;
+    }
+
+    for (sign1 = 0; sign1 < 64; sign1++) {
+        for (sign2 = 0; sign2 < 65; sign2++) {
+            if (phonemeNames[sign1][sign2] != computed[sign1][sign2]) {
+                printf("'%c' followed by %d differs\n", sign1 + ' ', sign2 + ' ');
+                failures++;
+            }
+        }
+    }
+    if (failures) printf("%d failures, regenerate PhonemeNameTabs.h with \"print\"\n", failures);
+    return failures != 0;
+}
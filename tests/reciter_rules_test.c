@@ -0,0 +1,133 @@
+// The reciter rule table in ReciterRuleTabs.h matches a scan of the rule
+// bytes in ReciterTabs.h. Run with "print" to write a new table to stdout
+// instead, after the rule bytes have changed.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ReciterTabs.h"
+#include "ReciterRuleTabs.h"
+
+static unsigned char GetRuleByte(unsigned short mem62, unsigned char Y)
+{
+    if (mem62 >= 37541) return rules2[mem62 - 37541 + Y];
+    return rules[mem62 - 32000 + Y];
+}
+
+static ReciterRule scanned[512];
+static short scannedStart[27];
+static short scannedEnd[27];
+static int scannedCount;
+
+// Locates the rules the way the matcher walks them from each of the 26
+// letter entry points and the punctuation entry point.
+static void ScanRules()
+{
+    int section, count = 0;
+
+    for (section = 0; section < 27; section++) {
+        unsigned short mem62 = 37541;
+        if (section < 26) mem62 = tab37489[section] | (tab37515[section]<<8);
+
+        scannedStart[section] = count;
+        while (count < 512) {
+            ReciterRule *rule;
+            unsigned char Y;
+
+            while ((GetRuleByte(++mem62, 0) & 128) == 0);
+            // ']' starts the next letter, a lone flagged byte ends the table.
+            // Some entry points lie just before the ']' of their own letter,
+            // which the matcher then reads as part of the first rule.
+            Y = GetRuleByte(mem62, 1);
+            if (count > scannedStart[section] && (Y == ']' || (Y & 128))) break;
+
+            rule = &scanned[count++];
+            rule->address = mem62;
+            if (mem62 >= 37541)
+                rule->bytes = (const unsigned char*)rules2 + (mem62 - 37541);
+            else
+                rule->bytes = (const unsigned char*)rules + (mem62 - 32000);
+
+            Y = 0;
+            while (GetRuleByte(mem62, ++Y) != '(');
+            rule->open = Y;
+            while (GetRuleByte(mem62, ++Y) != ')');
+            rule->close = Y;
+            while ((GetRuleByte(mem62, ++Y) & 127) != '=');
+            rule->equals = Y;
+        }
+        scannedEnd[section] = count;
+    }
+    scannedCount = count;
+}
+
+static void Print()
+{
+    int i;
+
+    printf("#ifndef RECITERRULETABS_H\n");
+    printf("#define RECITERRULETABS_H\n\n");
+    printf("// Every reciter rule in the order SamTextToPhonemes tries them, sections\n");
+    printf("// 0-25 for the letters A-Z and 26 for punctuation and digits. bytes[Y] is\n");
+    printf("// GetRuleByte(address, Y). Generated by tests/reciter_rules_test.c from\n");
+    printf("// rules and rules2 in ReciterTabs.h, which must be included first.\n");
+    printf("typedef struct\n{\n");
+    printf("\tconst unsigned char *bytes;\n");
+    printf("\tunsigned short address;\n");
+    printf("\tunsigned char open;   // position of '('\n");
+    printf("\tunsigned char close;  // position of ')'\n");
+    printf("\tunsigned char equals; // position of '='\n");
+    printf("} ReciterRule;\n\n");
+    printf("#define RULE1(a) ((const unsigned char*)rules + ((a) - 32000)), (a)\n");
+    printf("#define RULE2(a) ((const unsigned char*)rules2 + ((a) - 37541)), (a)\n\n");
+
+    printf("const ReciterRule reciterRules[%d] =\n{\n", scannedCount);
+    for (i = 0; i < scannedCount; i++) {
+        printf("\t{ RULE%d(%d), %d, %d, %d },\n", scanned[i].address >= 37541 ? 2 : 1,
+               scanned[i].address, scanned[i].open, scanned[i].close, scanned[i].equals);
+    }
+    printf("};\n\n");
+
+    printf("#undef RULE1\n#undef RULE2\n\n");
+
+    printf("const short reciterSectionStart[27] =\n{\n\t");
+    for (i = 0; i < 27; i++) printf("%d%s", scannedStart[i], i == 26 ? "\n" : (i % 9 == 8 ? ",\n\t" : ", "));
+    printf("};\n\n");
+    printf("const short reciterSectionEnd[27] =\n{\n\t");
+    for (i = 0; i < 27; i++) printf("%d%s", scannedEnd[i], i == 26 ? "\n" : (i % 9 == 8 ? ",\n\t" : ", "));
+    printf("};\n\n");
+    printf("#endif\n");
+}
+
+int main(int argc, char **argv)
+{
+    int failures = 0;
+    int i;
+
+    ScanRules();
+    if (argc > 1 && strcmp(argv[1], "print") == 0) {
+        Print();
+        return 0;
+    }
+
+    if (sizeof(reciterRules) / sizeof(reciterRules[0]) != (size_t)scannedCount) {
+        printf("table has %d rules, scan finds %d\n", (int)(sizeof(reciterRules) / sizeof(reciterRules[0])), scannedCount);
+        return 1;
+    }
+    for (i = 0; i < scannedCount; i++) {
+        const ReciterRule *a = &reciterRules[i], *b = &scanned[i];
+        if (a->bytes != b->bytes || a->address != b->address || a->open != b->open ||
+            a->close != b->close || a->equals != b->equals) {
+            printf("rule %d differs\n", i);
+            failures++;
+        }
+    }
+    for (i = 0; i < 27; i++) {
+        if (reciterSectionStart[i] != scannedStart[i] || reciterSectionEnd[i] != scannedEnd[i]) {
+            printf("section %d differs\n", i);
+            failures++;
+        }
+    }
+    if (failures) printf("%d failures, regenerate ReciterRuleTabs.h with \"print\"\n", failures);
+    return failures != 0;
+}
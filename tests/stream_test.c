@@ -0,0 +1,122 @@
+// Streamed and parsed-phrase renders give exactly the samples of a whole
+// buffer SamMain render, whatever the read size and the voice settings.
+
+#include "test_util.h"
+
+static const char *kTexts[] = {
+    "HELLO WORLD, THIS IS SAM SPEAKING.",
+    "SHE SELLS SEA SHELLS BY THE SEA SHORE. SIX THICK THISTLE STICKS.",
+    "I AM SAM",
+    "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG WHILE THE HUNGRY WIZARD QUIETLY VEXES THE JUMBLED SPHINX.",
+    "ZEBRA VISION JUDGE CHURCH? YES!",
+};
+
+static const int kReadSizes[] = { 1, 7, 64, 333, 4096, 100000 };
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+static void SetVoice(SamContext *ctx, int v)
+{
+    SamSetSpeed(ctx, (unsigned char)(72 + 11 * v));
+    SamSetPitch(ctx, (unsigned char)(64 + 23 * v));
+    SamSetMouth(ctx, (unsigned char)(128 + 31 * v));
+    SamSetThroat(ctx, (unsigned char)(128 - 17 * v));
+}
+
+// Reads the whole stream in pieces of readSize samples.
+static Render ReadStream(SamContext *ctx, int readSize)
+{
+    Render r;
+    int size = 1 << 16;
+    r.samples = malloc(size);
+    r.count = 0;
+    r.ok = 1;
+    while (1) {
+        int n;
+        if (r.count + readSize > size) {
+            while (r.count + readSize > size) size *= 2;
+            r.samples = realloc(r.samples, size);
+        }
+        n = SamStreamRead(ctx, r.samples + r.count, readSize);
+        r.count += n;
+        if (n < readSize) break;
+    }
+    return r;
+}
+
+// Storage handed to the engine through SamSetBufferAlloc.
+static char* GrowBuffer(void *user, char *buffer, int size)
+{
+    (void)user;
+    return realloc(buffer, size);
+}
+
+int main()
+{
+    SamContext *ctx = SamCreateContext();
+    SamContext *stream = SamCreateContext();
+    unsigned char *phonemes = malloc(256);
+    int t, v, s;
+
+    for (t = 0; t < COUNT(kTexts); t++) {
+        SamPhrase *phrase;
+
+        CHECK(ToPhonemes(ctx, kTexts[t], phonemes), "text %d did not convert", t);
+        SamSetInput(ctx, phonemes);
+        SamSetInput(stream, phonemes);
+        phrase = SamParse(stream);
+        CHECK(phrase != NULL, "text %d did not parse", t);
+
+        for (v = 0; v < 3; v++) {
+            Render whole, parsed;
+
+            SetVoice(ctx, v);
+            SetVoice(stream, v);
+            whole = TakeRender(ctx, SamMain(ctx));
+            CHECK(whole.ok && whole.count > 0, "text %d voice %d did not render", t, v);
+
+            parsed = TakeRender(stream, SamRenderPhrase(stream, phrase));
+            CHECK(SameRender(&whole, &parsed), "text %d voice %d: SamRenderPhrase differs", t, v);
+            free(parsed.samples);
+
+            for (s = 0; s < COUNT(kReadSizes); s++) {
+                Render streamed;
+
+                SamSetInput(stream, phonemes);
+                CHECK(SamStreamBegin(stream), "text %d: SamStreamBegin failed", t);
+                streamed = ReadStream(stream, kReadSizes[s]);
+                CHECK(SameRender(&whole, &streamed), "text %d voice %d read size %d: stream differs (%d vs %d samples)",
+                      t, v, kReadSizes[s], streamed.count, whole.count);
+                free(streamed.samples);
+
+                CHECK(SamStreamBeginPhrase(stream, phrase), "text %d: SamStreamBeginPhrase failed", t);
+                streamed = ReadStream(stream, kReadSizes[s]);
+                CHECK(SameRender(&whole, &streamed), "text %d voice %d read size %d: phrase stream differs",
+                      t, v, kReadSizes[s]);
+                free(streamed.samples);
+            }
+
+            // caller storage holds the same samples as the context's own buffer
+            {
+                Render caller;
+                char *storage = NULL;
+                SamSetBufferAlloc(ctx, GrowBuffer, NULL);
+                caller = TakeRender(ctx, SamMain(ctx));
+                storage = SamGetBuffer(ctx);
+                SamSetBufferAlloc(ctx, NULL, NULL);
+                free(storage);
+                CHECK(SameRender(&whole, &caller), "text %d voice %d: caller storage differs", t, v);
+                free(caller.samples);
+            }
+
+            free(whole.samples);
+        }
+        SamDestroyPhrase(phrase);
+    }
+
+    free(phonemes);
+    SamDestroyContext(stream);
+    SamDestroyContext(ctx);
+    if (failures) printf("%d failures\n", failures);
+    return failures != 0;
+}
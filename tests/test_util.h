@@ -0,0 +1,70 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+// Shared by the engine tests. Each test is a program that prints every
+// failed check and returns nonzero if there was one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sam.h"
+#include "reciter.h"
+
+int debug = 0;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+// Output of one render, copied out of the context.
+typedef struct
+{
+    unsigned char *samples;
+    int count;
+    int ok;
+} Render;
+
+static inline Render TakeRender(SamContext *ctx, int ok)
+{
+    Render r;
+    r.count = SamGetBufferLength(ctx) / 50;
+    r.samples = malloc(r.count > 0 ? r.count : 1);
+    if (r.count > 0) memcpy(r.samples, SamGetBuffer(ctx), r.count);
+    r.ok = ok;
+    return r;
+}
+
+static inline int SameRender(const Render *a, const Render *b)
+{
+    return a->ok == b->ok && a->count == b->count && memcmp(a->samples, b->samples, a->count) == 0;
+}
+
+// FNV-1a hash of the samples, for comparing with renders of the original
+// engine.
+static inline unsigned int Hash(const Render *r)
+{
+    unsigned int hash = 2166136261u;
+    int i;
+    for (i = 0; i < r->count; i++) hash = (hash ^ r->samples[i]) * 16777619u;
+    return hash;
+}
+
+// Runs text through SamTextToPhonemes. out needs 256 bytes.
+static inline int ToPhonemes(SamContext *ctx, const char *text, unsigned char *out)
+{
+    memset(out, 0, 256);
+    strcpy((char*)out, text);
+    strcat((char*)out, "[");
+    return SamTextToPhonemes(ctx, out);
+}
+
+#endif
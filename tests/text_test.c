@@ -0,0 +1,130 @@
+// SamSetText gives the input SamTextToPhonemes and SamSetInput would, and
+// a text recited word by word with SamWordToPhonemes matches the whole
+// text recited at once.
+
+#include "test_util.h"
+
+static const char *kTexts[] = {
+    "HELLO WORLD",
+    "HELLO WORLD, THIS IS SAM SPEAKING.",
+    "THE OLD MAN AND THE SEA. THE END?",
+    "I AM SAM, SAM I AM",
+    "THE APPLE IS THE ONLY THE ONE",
+    "FOUR SCORE AND SEVEN YEARS AGO OUR FATHERS BROUGHT FORTH",
+    "PRICE 25 DOLLARS, 10 CENTS.",
+};
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+// Renders whose rules look at the phoneme after END, with the FNV-1a hash
+// of the samples the original engine gives them. SamSetText adds no pause
+// at the end, so the vowel rules in AdjustLengths see END straight after
+// the last vowel of "SEE", "HELLO" and "VST".
+static const struct
+{
+    const char *text;
+    unsigned int hash;
+} kEndRules[] = {
+    { "WORLD", 0x767CA815 },
+    { "HELLO WORLD", 0xC0DA3A2F },
+    { "ODD", 0xB12B698D },
+    { "KEEP BACK", 0x9A2FF2CD },
+    { "SEE", 0xBF3E469F },
+    { "HELLO", 0x4E960465 },
+    { "VST", 0x75163F37 },
+    { "T OF THE D", 0x68518DC5 },
+};
+
+static int IsVowel(char c)
+{
+    return c == 'A' || c == 'E' || c == 'I' || c == 'O' || c == 'U' || c == 'Y';
+}
+
+// Same assembly as the plugin: a pause, then each word with a pause for
+// every space. out needs 256 bytes.
+static int ReciteWords(SamContext *ctx, const char *text, char *out)
+{
+    unsigned char word[256];
+    int pos = 0, total = strlen(text);
+
+    strcpy(out, " ");
+    while (pos < total) {
+        int end;
+        if (text[pos] == ' ') {
+            strcat(out, " ");
+            pos++;
+            continue;
+        }
+        for (end = pos; end < total && text[end] != ' '; end++);
+        if (!SamWordToPhonemes(ctx, text + pos, end - pos, end + 1 < total && IsVowel(text[end + 1]), word))
+            return 0;
+        if (strlen(out) + strlen((char*)word) >= 256) return 0;
+        strcat(out, (char*)word);
+        pos = end;
+    }
+    return 1;
+}
+
+int main()
+{
+    SamContext *ctx = SamCreateContext();
+    unsigned char *phonemes = malloc(256);
+    char *words = malloc(256);
+    char *longText;
+    int t, k;
+
+    for (t = 0; t < COUNT(kTexts); t++) {
+        Render recited, set;
+
+        CHECK(ToPhonemes(ctx, kTexts[t], phonemes), "text %d did not convert", t);
+        for (k = 0; phonemes[k] != 155 && k < 255; k++);
+        phonemes[k] = 0;
+
+        CHECK(ReciteWords(ctx, kTexts[t], words), "text %d: a word did not convert", t);
+        CHECK(strcmp((char*)phonemes, words) == 0, "text %d: words give \"%s\", text gives \"%s\"",
+              t, words, (char*)phonemes);
+
+        SamSetInput(ctx, phonemes);
+        recited = TakeRender(ctx, SamMain(ctx));
+        CHECK(SamSetText(ctx, kTexts[t]), "text %d: SamSetText failed", t);
+        set = TakeRender(ctx, SamMain(ctx));
+        CHECK(recited.ok && SameRender(&recited, &set), "text %d: SamSetText renders differently", t);
+        free(recited.samples);
+        free(set.samples);
+    }
+
+    for (t = 0; t < COUNT(kEndRules); t++) {
+        Render r;
+        CHECK(SamSetText(ctx, kEndRules[t].text), "%s did not convert", kEndRules[t].text);
+        r = TakeRender(ctx, SamMain(ctx));
+        CHECK(r.ok && Hash(&r) == kEndRules[t].hash, "%s renders differently, hash 0x%08X", kEndRules[t].text, Hash(&r));
+        free(r.samples);
+    }
+
+    // words the reciter cannot take on their own
+    CHECK(!SamWordToPhonemes(ctx, "EXTRAORDINARILYLONG", 19, 0, phonemes), "overlong word converted");
+    CHECK(!SamWordToPhonemes(ctx, "", 0, 0, phonemes), "empty word converted");
+
+    // text far past the reciter's 256 byte buffer still renders in full
+    longText = malloc(40 * 35 + 1);
+    longText[0] = 0;
+    for (k = 0; k < 40; k++) strcat(longText, "THE RAIN IN SPAIN STAYS MAINLY. ");
+    CHECK(SamSetText(ctx, longText), "long text failed");
+    {
+        Render whole = TakeRender(ctx, SamMain(ctx));
+        Render one;
+        CHECK(SamSetText(ctx, "THE RAIN IN SPAIN STAYS MAINLY. "), "sentence failed");
+        one = TakeRender(ctx, SamMain(ctx));
+        CHECK(whole.ok && whole.count > 30 * one.count,
+              "long text rendered %d samples, one sentence %d", whole.count, one.count);
+        free(whole.samples);
+        free(one.samples);
+    }
+    free(longText);
+
+    free(words);
+    free(phonemes);
+    SamDestroyContext(ctx);
+    if (failures) printf("%d failures\n", failures);
+    return failures != 0;
+}